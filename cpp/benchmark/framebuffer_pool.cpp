@@ -0,0 +1,96 @@
+//
+//  framebuffer_pool.cpp
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+//  Cost of the buffer of a frame: allocated with new[] for every frame, the way Fractal_view used to, against taken
+//  from a Framebuffer_pool with each page backing.  A frame writes one pixel per page of its buffer, so the numbers
+//  are those of the allocation and its page faults rather than of rendering.  The first frame from a pool maps and
+//  pre-faults the buffer, the later ones reuse it.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "fractal/framebuffer_pool.h"
+
+namespace
+{
+
+long page_faults()
+{
+#ifndef _WIN32
+  auto usage = rusage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+#else
+  return 0;
+#endif
+}
+
+// Where the frames are published, so the compiler can't drop a buffer nobody reads.
+uint32_t* volatile g_frame = nullptr;
+
+// Writes a pixel a page.
+void touch(uint32_t* buffer, size_t size)
+{
+  g_frame = buffer;
+  for (size_t i = 0; i < size; i += 1024)
+  {
+    buffer[i] = static_cast<uint32_t>(i);
+  }
+}
+
+template <typename Frame>
+void measure(const char* name, int frame_count, Frame frame)
+{
+  for (int i = 0; i < frame_count; ++i)
+  {
+    auto faults = page_faults();
+    auto start = std::chrono::steady_clock::now();
+    frame();
+    auto milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%22s %6d %12.2f %12ld\n", name, i, milliseconds, page_faults() - faults);
+  }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  // Optional arguments: side of the frame and frames per allocator.
+  auto side = argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : size_t{16384};
+  auto frame_count = argc > 2 ? std::atoi(argv[2]) : 4;
+  const auto size = side * side;
+
+  std::printf("%zu x %zu pixels, %.0f MiB a frame\n", side, side, size * sizeof(uint32_t) / 1048576.0);
+  std::printf("%22s %6s %12s %12s\n", "allocator", "frame", "ms", "page faults");
+
+  measure("new[]", frame_count, [&]()
+  {
+    auto buffer = std::unique_ptr<uint32_t[]>{new uint32_t[size]};
+    touch(buffer.get(), size);
+  });
+
+  auto backings = {std::make_pair("pool, normal pages", Fractal::Page_backing::normal),
+                   std::make_pair("pool, transparent huge", Fractal::Page_backing::transparent_huge),
+                   std::make_pair("pool, huge", Fractal::Page_backing::huge)};
+  for (const auto& backing : backings)
+  {
+    Fractal::Framebuffer_pool pool{backing.second, size * sizeof(uint32_t)};
+    measure(backing.first, frame_count, [&]()
+    {
+      auto buffer = pool.acquire<uint32_t>(size);
+      touch(buffer.get(), size);
+    });
+  }
+  return 0;
+}
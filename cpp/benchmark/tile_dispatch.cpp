@@ -0,0 +1,218 @@
+//
+//  tile_dispatch.cpp
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+//  Tile dispatch throughput of the work stealing pool Distributed_generator runs on against the single mutex
+//  queue it used before, at 1 to 64 threads.  Tasks stand in for tiles: they spin for a fixed number of
+//  nanoseconds so the numbers measure the dispatch rather than the fractal.  The flat workload pushes every tile
+//  from the invoking thread, the nested one has each tile split in four like subdivision does.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "fractal/work_stealing_pool.h"
+
+namespace
+{
+
+// The dispatch Distributed_generator had: one queue and one mutex shared by every worker and by the invoker.
+class Mutex_queue_pool final
+{
+public:
+  using Task = std::function<void()>;
+
+  Mutex_queue_pool(size_t thread_count)
+  {
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+      m_threads.emplace_back([this]()
+      {
+        run_();
+      });
+    }
+  }
+  Mutex_queue_pool(const Mutex_queue_pool&) = delete;
+  Mutex_queue_pool(Mutex_queue_pool&&) = delete;
+  ~Mutex_queue_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock{m_tasks_mutex};
+      m_destructing = true;
+    }
+    m_task_ready_condition.notify_all();
+    for (auto& thread : m_threads)
+    {
+      thread.join();
+    }
+  }
+
+  Mutex_queue_pool& operator=(const Mutex_queue_pool&) = delete;
+  Mutex_queue_pool& operator=(Mutex_queue_pool&&) = delete;
+
+  void push(Task task)
+  {
+    {
+      std::lock_guard<std::mutex> lock{m_tasks_mutex};
+      m_tasks.emplace(std::move(task));
+    }
+    m_task_ready_condition.notify_one();
+  }
+
+  void wait()
+  {
+    auto lock = std::unique_lock<std::mutex>{m_tasks_mutex};
+    m_task_done_condition.wait(lock, [&]()
+    {
+      return m_tasks.empty() && m_executing_task_count == 0;
+    });
+  }
+
+private:
+  void run_()
+  {
+    auto lock = std::unique_lock<std::mutex>{m_tasks_mutex};
+    while (true)
+    {
+      m_task_ready_condition.wait(lock, [&]()
+      {
+        return !m_tasks.empty() || m_destructing;
+      });
+      if (m_destructing)
+      {
+        return;
+      }
+
+      auto task = std::move(m_tasks.front());
+      m_tasks.pop();
+      ++m_executing_task_count;
+      lock.unlock();
+      task();
+      lock.lock();
+      --m_executing_task_count;
+      if (m_tasks.empty() && m_executing_task_count == 0)
+      {
+        m_task_done_condition.notify_all();
+      }
+    }
+  }
+
+private:
+  std::queue<Task> m_tasks;
+  std::mutex m_tasks_mutex;
+  std::condition_variable m_task_ready_condition;
+  std::condition_variable m_task_done_condition;
+  size_t m_executing_task_count{0};
+  bool m_destructing{false};
+  std::vector<std::thread> m_threads;
+};
+
+void spin(std::chrono::nanoseconds duration)
+{
+  auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end)
+  {
+  }
+}
+
+template <typename Pool>
+void push_flat(Pool& pool, size_t tile_count, std::chrono::nanoseconds work)
+{
+  for (size_t i = 0; i < tile_count; ++i)
+  {
+    pool.push([work]()
+    {
+      spin(work);
+    });
+  }
+}
+
+template <typename Pool>
+void push_nested(Pool& pool, size_t depth, std::chrono::nanoseconds work)
+{
+  pool.push([&pool, depth, work]()
+  {
+    spin(work);
+    if (depth > 0)
+    {
+      for (size_t i = 0; i < 4; ++i)
+      {
+        push_nested(pool, depth - 1, work);
+      }
+    }
+  });
+}
+
+// Tiles per second over the best of a few rounds.
+template <typename Pool>
+double measure(size_t thread_count, bool nested, size_t tile_count, std::chrono::nanoseconds work)
+{
+  // Four levels of quartering from 16 roots, 16 * (1 + 4 + 16 + 64 + 256) = 5456 tiles.
+  const auto nested_depth = size_t{4};
+  const auto nested_roots = size_t{16};
+  const auto nested_count = nested_roots * ((size_t{1} << (2 * (nested_depth + 1))) - 1) / 3;
+
+  Pool pool{thread_count};
+  auto best = std::chrono::duration<double>::max();
+  for (size_t round = 0; round < 5; ++round)
+  {
+    auto start = std::chrono::steady_clock::now();
+    if (nested)
+    {
+      for (size_t i = 0; i < nested_roots; ++i)
+      {
+        push_nested(pool, nested_depth, work);
+      }
+    }
+    else
+    {
+      push_flat(pool, tile_count, work);
+    }
+    pool.wait();
+    best = std::min<std::chrono::duration<double>>(best, std::chrono::steady_clock::now() - start);
+  }
+  return static_cast<double>(nested ? nested_count : tile_count) / best.count();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  // Optional arguments: tile count of the flat workload and nanoseconds of work per tile.
+  auto tile_count = argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : size_t{20000};
+  auto work = std::chrono::nanoseconds{argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 0};
+
+  std::printf("%u hardware threads, %zu flat tiles, %lld ns per tile\n",
+              std::thread::hardware_concurrency(),
+              tile_count,
+              static_cast<long long>(work.count()));
+  std::printf("%8s %10s %16s %16s %8s\n", "threads", "workload", "mutex queue/s", "stealing/s", "speedup");
+
+  for (size_t thread_count : {1, 2, 4, 8, 16, 32, 64})
+  {
+    for (auto nested : {false, true})
+    {
+      auto queue = measure<Mutex_queue_pool>(thread_count, nested, tile_count, work);
+      auto stealing = measure<Fractal::Work_stealing_pool>(thread_count, nested, tile_count, work);
+      std::printf("%8zu %10s %16.0f %16.0f %7.2fx\n",
+                  thread_count,
+                  nested ? "nested" : "flat",
+                  queue,
+                  stealing,
+                  stealing / queue);
+    }
+  }
+  return 0;
+}
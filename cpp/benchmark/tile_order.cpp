@@ -0,0 +1,234 @@
+//
+//  tile_order.cpp
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+//  Cache misses per pixel of rendering a view in the tile order Generator_task_parameters::distribute cuts it in,
+//  down the columns with every tile a task of its own, against the tiles along a Morton or Hilbert curve handed to
+//  the workers in contiguous runs (Tile_assignment::contiguous).  Each tile is copied out to a linear image as it
+//  completes, the way the subscriber and publisher assemble a view.  The function stops after a few iterations and
+//  the view keeps escape counts, so the numbers measure the memory traffic rather than the fractal.  The misses
+//  come from the hardware counters of the process, Linux only, and read n/a where those aren't available.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "fractal/distributed_generator.h"
+#include "fractal/mandlebrot_function.h"
+
+namespace
+{
+
+// Counts an event over the process and the threads it starts from then on, the workers of the pool included.
+class Event_counter final
+{
+public:
+  Event_counter(uint32_t type, uint64_t config)
+  {
+#ifdef __linux__
+    auto attributes = perf_event_attr{};
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.inherit = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    m_descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#else
+    (void)type;
+    (void)config;
+#endif
+  }
+  Event_counter(const Event_counter&) = delete;
+  Event_counter(Event_counter&&) = delete;
+  ~Event_counter()
+  {
+#ifdef __linux__
+    if (m_descriptor >= 0)
+    {
+      close(m_descriptor);
+    }
+#endif
+  }
+
+  Event_counter& operator=(const Event_counter&) = delete;
+  Event_counter& operator=(Event_counter&&) = delete;
+
+  bool available() const
+  {
+    return m_descriptor >= 0;
+  }
+
+  void start()
+  {
+#ifdef __linux__
+    if (available())
+    {
+      ioctl(m_descriptor, PERF_EVENT_IOC_RESET, 0);
+      ioctl(m_descriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t stop()
+  {
+    auto count = uint64_t{0};
+#ifdef __linux__
+    if (available())
+    {
+      ioctl(m_descriptor, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(m_descriptor, &count, sizeof(count)) != sizeof(count))
+      {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+private:
+  int m_descriptor{-1};
+};
+
+struct Result
+{
+  double megapixels_per_second{0.0};
+  double cache_misses_per_pixel{-1.0};
+  double tlb_misses_per_pixel{-1.0};
+};
+
+// Best of a few runs.
+Result measure(Fractal::Distributed_generator& generator,
+               Fractal::Fractal_view& view,
+               uint32_t* image,
+               size_t tile_size,
+               Fractal::Tile_order tile_order,
+               size_t max_iterations,
+               Event_counter& cache_misses,
+               Event_counter& tlb_misses)
+{
+  const auto width = view.pixel_view().width();
+  auto assemble = [view, image, width](const Fractal::Task_parameters& parameters)
+  {
+    const auto& tile = static_cast<const Fractal::Generator_task_parameters&>(parameters).pixel_tile_view;
+    view.read(tile, image + tile.left + tile.top * width, width);
+  };
+  auto ignore = [](const Fractal::Task_parameters&) {};
+
+  auto pixels = static_cast<double>(width * view.pixel_view().height());
+  auto result = Result{};
+  for (int run = 0; run < 3; ++run)
+  {
+    auto tiles = Fractal::Generator_task_parameters::distribute("benchmark",
+                                                                std::make_shared<std::atomic<bool>>(false),
+                                                                assemble,
+                                                                ignore,
+                                                                view,
+                                                                tile_size,
+                                                                tile_size,
+                                                                Fractal::Symmetry::none,
+                                                                tile_order);
+    cache_misses.start();
+    tlb_misses.start();
+    auto start = std::chrono::steady_clock::now();
+    generator(Fractal::Mandlebrot_function{max_iterations}, tiles);
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto cache = cache_misses.stop();
+    auto tlb = tlb_misses.stop();
+
+    if (pixels / seconds / 1e6 > result.megapixels_per_second)
+    {
+      result.megapixels_per_second = pixels / seconds / 1e6;
+      result.cache_misses_per_pixel = cache_misses.available() ? cache / pixels : -1.0;
+      result.tlb_misses_per_pixel = tlb_misses.available() ? tlb / pixels : -1.0;
+    }
+  }
+  return result;
+}
+
+void print(const char* name, size_t tile_size, const Result& result, const Result& baseline)
+{
+  auto per_pixel = [](double value, char* text, size_t size)
+  {
+    if (value < 0.0)
+    {
+      std::snprintf(text, size, "n/a");
+    }
+    else
+    {
+      std::snprintf(text, size, "%.4f", value);
+    }
+  };
+  char cache[32];
+  char tlb[32];
+  per_pixel(result.cache_misses_per_pixel, cache, sizeof(cache));
+  per_pixel(result.tlb_misses_per_pixel, tlb, sizeof(tlb));
+  std::printf("%14s %5zu %12.1f %8.2fx %16s %16s\n",
+              name,
+              tile_size,
+              result.megapixels_per_second,
+              result.megapixels_per_second / baseline.megapixels_per_second,
+              cache,
+              tlb);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  // Optional arguments: side of the image, iterations per pixel at most and worker threads.
+  auto side = argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : size_t{8192};
+  auto max_iterations = argc > 2 ? static_cast<size_t>(std::strtoull(argv[2], nullptr, 10)) : size_t{8};
+  auto thread_count = argc > 3 ? static_cast<size_t>(std::strtoull(argv[3], nullptr, 10)) : size_t{std::thread::hardware_concurrency()};
+
+  // Opened before the pool starts its workers, so their events are counted too.
+#ifdef __linux__
+  Event_counter cache_misses{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+  Event_counter tlb_misses{PERF_TYPE_HW_CACHE,
+                           PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+#else
+  Event_counter cache_misses{0, 0};
+  Event_counter tlb_misses{0, 0};
+#endif
+
+  auto view = Fractal::Fractal_view{Fractal::Fractal_view::Pixel_view{0, 0, side, side},
+                                    Fractal::Fractal_view::Complex_view{-2.0, -1.5, 1.0, 1.5}};
+  view.set_iteration_buffer(Fractal::Iteration_count::uint32, true);
+  auto image = std::vector<uint32_t>(side * side);
+
+  Fractal::Distributed_generator generator{std::max(thread_count, size_t{1})};
+
+  std::printf("%zu x %zu pixels, at most %zu iterations, %zu threads\n", side, side, max_iterations, thread_count);
+  std::printf("%14s %5s %12s %9s %16s %16s\n", "order", "tile", "Mpx/s", "speedup", "cache miss/px", "dTLB miss/px");
+
+  for (auto tile_size : {size_t{32}, size_t{64}, size_t{128}})
+  {
+    generator.set_tile_assignment(Fractal::Tile_assignment::shared);
+    auto columns = measure(generator, view, image.data(), tile_size, Fractal::Tile_order::distributed, max_iterations, cache_misses, tlb_misses);
+    print("column-major", tile_size, columns, columns);
+
+    generator.set_tile_assignment(Fractal::Tile_assignment::contiguous);
+    auto morton = measure(generator, view, image.data(), tile_size, Fractal::Tile_order::morton, max_iterations, cache_misses, tlb_misses);
+    print("morton runs", tile_size, morton, columns);
+    auto hilbert = measure(generator, view, image.data(), tile_size, Fractal::Tile_order::hilbert, max_iterations, cache_misses, tlb_misses);
+    print("hilbert runs", tile_size, hilbert, columns);
+  }
+  return 0;
+}
@@ -0,0 +1,205 @@
+//
+//  tile_traversal.cpp
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+//  How Distributed_generator walks the pixels of a tile on an 8192 pixel wide image, against the way it used to.
+//  Functions evaluated a pixel at a time used to be walked down the columns, every write a row of the image (32 KiB)
+//  after the last; they now go row by row into a scratch row copied out whole.  Tile functions used to write
+//  straight into the image with its stride, they now fill a scratch tile copied out a row at a time.  The functions
+//  stop after a few iterations so the numbers measure the memory traffic rather than the fractal.  The old
+//  traversals run inline, the new ones through a generator of one thread, which pays for queuing the tiles too.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "fractal/distributed_generator.h"
+#include "fractal/mandlebrot_function.h"
+
+namespace
+{
+
+// Escape time of the Mandlebrot set a pixel at a time, the generator has nothing faster to call.
+class Pixel_function final
+{
+public:
+  Pixel_function(size_t max_iterations)
+  : m_max_iterations{max_iterations}
+  {
+  }
+
+  uint32_t operator()(std::complex<double> c, const std::shared_ptr<std::atomic<bool>>&) const
+  {
+    auto z = std::complex<double>{};
+    size_t i = 0;
+    for (; i < m_max_iterations && std::norm(z) <= 4.0; ++i)
+    {
+      z = z * z + c;
+    }
+    return 0xff000000 | static_cast<uint32_t>(i * 0x010101);
+  }
+
+private:
+  size_t m_max_iterations;
+};
+
+// The traversal the generator had for pixel functions: i over the columns outside, j over the rows inside.
+void column_major(const Pixel_function& function, Fractal::Generator_task_parameters& tp)
+{
+  auto real_factor = tp.fractal_view.complex_view().width() / static_cast<double>(tp.fractal_view.pixel_view().width());
+  auto imaginary_factor = tp.fractal_view.complex_view().height() / static_cast<double>(tp.fractal_view.pixel_view().height());
+  auto c = std::complex<double>{};
+  for (size_t i = tp.pixel_tile_view.left; i < tp.pixel_tile_view.right; ++i)
+  {
+    c.real(tp.fractal_view.complex_view().left + i * real_factor);
+    for (size_t j = tp.pixel_tile_view.top; j < tp.pixel_tile_view.bottom; ++j)
+    {
+      c.imag(tp.fractal_view.complex_view().top + j * imaginary_factor);
+      tp.fractal_view.buffer().get()[i + j * tp.fractal_view.pixel_view().width()] = function(c, tp.cancel_token);
+    }
+  }
+}
+
+// Tile functions as the generator called them: coordinate tables per tile and the image's stride.
+void strided(const Fractal::Mandlebrot_function& function, Fractal::Generator_task_parameters& tp)
+{
+  const auto& view = tp.fractal_view;
+  auto real_factor = view.complex_view().width() / static_cast<double>(view.pixel_view().width());
+  auto imaginary_factor = view.complex_view().height() / static_cast<double>(view.pixel_view().height());
+  auto real = std::vector<double>(tp.pixel_tile_view.width());
+  auto imaginary = std::vector<double>(tp.pixel_tile_view.height());
+  for (size_t i = 0; i < real.size(); ++i)
+  {
+    real[i] = view.complex_view().left + (i + tp.pixel_tile_view.left) * real_factor;
+  }
+  for (size_t j = 0; j < imaginary.size(); ++j)
+  {
+    imaginary[j] = view.complex_view().top + (j + tp.pixel_tile_view.top) * imaginary_factor;
+  }
+
+  auto stride = view.pixel_view().width();
+  function.invoke_tile(real.data(),
+                       real.size(),
+                       imaginary.data(),
+                       imaginary.size(),
+                       view.buffer().get() + tp.pixel_tile_view.left + tp.pixel_tile_view.top * stride,
+                       stride,
+                       tp.cancel_token);
+}
+
+std::vector<Fractal::Generator_task_parameters> tiles(const Fractal::Fractal_view& view, size_t tile_width, size_t tile_height)
+{
+  auto ignore = [](const Fractal::Task_parameters&) {};
+  return Fractal::Generator_task_parameters::distribute("benchmark",
+                                                        std::make_shared<std::atomic<bool>>(false),
+                                                        ignore,
+                                                        ignore,
+                                                        view,
+                                                        tile_width,
+                                                        tile_height);
+}
+
+// Best of a few runs, in megapixels per second.
+template <typename Render>
+double measure(const Fractal::Fractal_view& view, Render render)
+{
+  auto best = 0.0;
+  for (int run = 0; run < 3; ++run)
+  {
+    auto start = std::chrono::steady_clock::now();
+    render();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto pixels = static_cast<double>(view.pixel_view().width() * view.pixel_view().height());
+    best = std::max(best, pixels / seconds / 1e6);
+  }
+  return best;
+}
+
+size_t differences(const Fractal::Fractal_view& a, const Fractal::Fractal_view& b)
+{
+  auto count = size_t{0};
+  auto size = a.pixel_view().width() * a.pixel_view().height();
+  for (size_t i = 0; i < size; ++i)
+  {
+    count += a.buffer().get()[i] != b.buffer().get()[i];
+  }
+  return count;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  // Optional arguments: height of the image and iterations per pixel at most.
+  auto height = argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : size_t{2048};
+  auto max_iterations = argc > 2 ? static_cast<size_t>(std::strtoull(argv[2], nullptr, 10)) : size_t{8};
+  const auto width = size_t{8192};
+
+  auto pixel_view = Fractal::Fractal_view::Pixel_view{0, 0, width, height};
+  auto complex_view = Fractal::Fractal_view::Complex_view{-2.0, -1.0, 1.0, 1.0};
+  auto before = Fractal::Fractal_view{pixel_view, complex_view};
+  auto after = Fractal::Fractal_view{pixel_view, complex_view};
+
+  // One thread, so the numbers are those of the traversal alone.
+  Fractal::Distributed_generator generator{1};
+
+  std::printf("%zu x %zu pixels, at most %zu iterations\n", width, height, max_iterations);
+  std::printf("%10s %12s %16s %16s %8s %8s\n", "function", "tile", "before Mpx/s", "after Mpx/s", "speedup", "diff");
+
+  for (auto tile_size : {size_t{64}, size_t{256}, size_t{1024}})
+  {
+    auto pixel_function = Pixel_function{max_iterations};
+    auto old_pixels = measure(before, [&]()
+    {
+      for (auto& tp : tiles(before, tile_size, tile_size))
+      {
+        column_major(pixel_function, tp);
+      }
+    });
+    auto new_pixels = measure(after, [&]()
+    {
+      auto tasks = tiles(after, tile_size, tile_size);
+      generator(pixel_function, tasks);
+    });
+    std::printf("%10s %5zu x %4zu %16.1f %16.1f %7.2fx %8zu\n",
+                "pixel",
+                tile_size,
+                tile_size,
+                old_pixels,
+                new_pixels,
+                new_pixels / old_pixels,
+                differences(before, after));
+
+    auto tile_function = Fractal::Mandlebrot_function{max_iterations};
+    auto old_tiles = measure(before, [&]()
+    {
+      for (auto& tp : tiles(before, tile_size, tile_size))
+      {
+        strided(tile_function, tp);
+      }
+    });
+    auto new_tiles = measure(after, [&]()
+    {
+      auto tasks = tiles(after, tile_size, tile_size);
+      generator(tile_function, tasks);
+    });
+    std::printf("%10s %5zu x %4zu %16.1f %16.1f %7.2fx %8zu\n",
+                "tile",
+                tile_size,
+                tile_size,
+                old_tiles,
+                new_tiles,
+                new_tiles / old_tiles,
+                differences(before, after));
+  }
+  return 0;
+}
@@ -66,15 +66,9 @@ awsiotsdk::ResponseCode Publisher::handle_response_message_(const awsiotsdk::uti
   Fractal::print(std::cout, message);
 
   // Write tile to the view
-  for (size_t i = 0; i < message.header.device.width(); ++i)
+  if (message.argb_buffer.size() == message.header.device.width() * message.header.device.height())
   {
-    auto view_x_offset = i + message.header.device.left;
-    for (size_t j = 0; j < message.header.device.height(); ++j)
-    {
-      auto view_y_offset = j + message.header.device.top;
-      m_current_view.buffer().get()[view_x_offset + view_y_offset * m_current_view.pixel_view().height()]
-        = message.argb_buffer[i + j * message.header.device.height()];
-    }
+    m_current_view.write(message.header.device, message.argb_buffer.data(), message.header.device.width());
   }
 
   // Write current view to file
@@ -82,7 +76,7 @@ awsiotsdk::ResponseCode Publisher::handle_response_message_(const awsiotsdk::uti
     std::lock_guard<std::mutex> lk{m_mutex};
     auto out = std::ofstream{m_current_filename};
     Fractal::print(out, 
-                   m_current_view.buffer(), 
+                   m_current_view.linear_buffer(), 
                    m_current_view.pixel_view().width(), 
                    m_current_view.pixel_view().height());
   }
@@ -1,6 +1,7 @@
 #include <chrono>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 #ifdef USE_WEBSOCKETS
 #include "WebSocketConnection.hpp"
@@ -15,13 +16,15 @@
 #include "util/logging/ConsoleLogSystem.hpp"
 
 #include "ConfigCommon.hpp"
+#include "distance_estimation_function.h"
 #include "fractal_view.h"
 #include "mandlebrot_function.h"
+#include "perturbation_function.h"
 #include "subscriber.h"
 
 namespace Onboarding
 {
-awsiotsdk::ResponseCode Subscriber::publish_response_message_(const Fractal::Response_message& message)
+awsiotsdk::ResponseCode Subscriber::publish_response_message_(const Fractal::Response_view& message)
 {
   std::cout << "****** PUBLISHING RESPONSE MESSAGE *******" << std::endl;
   Fractal::print(std::cout, message);
@@ -47,55 +50,91 @@ awsiotsdk::ResponseCode Subscriber::handle_request_message_(const awsiotsdk::uti
   std::cout << "****** RECEIVED REQUEST MESSAGE ******" << std::endl;
   Fractal::print(std::cout, message);
 
+  // Each tile is a block of the view, its pixels go out from where they were rendered without being gathered.
+  const auto tile_size = size_t{128};
   auto fractal_view = Fractal::Fractal_view{message.header.device, message.header.complex};
+  fractal_view.set_blocked_layout(tile_size, tile_size);
   auto cancel_token = std::make_shared<std::atomic<bool>>(false);
   auto on_task_canceled = [](const Fractal::Task_parameters&){};      
-  auto on_task_completed = [&](const Fractal::Task_parameters& parameters)
+  // Runs on the workers after handle_request_message_ has returned, it holds on to what it needs.
+  auto on_task_completed = [this, fractal_view](const Fractal::Task_parameters& parameters)
   {
     const auto& generator_parameters = static_cast<const Fractal::Generator_task_parameters&>(parameters);
 
-    auto response_message = Fractal::Response_message{};
+    auto response_message = Fractal::Response_view{};
     response_message.header.header.type = Fractal::Response_message::ID;
     response_message.header.header.identifier = generator_parameters.identifier;
     response_message.header.complex = generator_parameters.complex_tile_view;
     response_message.header.device = generator_parameters.pixel_tile_view;
-    response_message.argb_buffer 
-      = std::vector<uint32_t>(generator_parameters.pixel_tile_view.width() * generator_parameters.pixel_tile_view.height(), 0);
+    response_message.argb = fractal_view.tile_span(generator_parameters.pixel_tile_view);
 
-    for (size_t i = 0; i < generator_parameters.pixel_tile_view.width(); ++i)
+    // A view no larger than a tile in one direction is rendered as a single tile across several blocks, which has no
+    // span of its own, so its pixels are gathered.
+    auto pixels = std::vector<uint32_t>{};
+    if (response_message.argb.data == nullptr)
     {
-      auto view_x_offset = i + generator_parameters.pixel_tile_view.left;
-      for (size_t j = 0; j < generator_parameters.pixel_tile_view.height(); ++j)
-      {
-        auto view_y_offset = j + generator_parameters.pixel_tile_view.top;
-        response_message.argb_buffer[i + j * generator_parameters.pixel_tile_view.height()]
-          = fractal_view.buffer().get()[view_x_offset + view_y_offset * fractal_view.pixel_view().height()];
-      }
+      const auto& tile = generator_parameters.pixel_tile_view;
+      pixels.resize(tile.width() * tile.height());
+      fractal_view.read(tile, pixels.data(), tile.width());
+      response_message.argb = Fractal::Argb_span{pixels.data(), tile.width(), tile.height(), tile.width()};
     }
 
     publish_response_message_(response_message);
   };
 
-  auto task_parameters = Fractal::Generator_task_parameters::distribute(message.header.header.identifier,
-                                                                        cancel_token,
-                                                                        on_task_completed,
-                                                                        on_task_canceled,
-                                                                        fractal_view,
-                                                                        128,
-                                                                        128);
+  // The tiles are made as they are rendered rather than all up front.
+  auto tiles = Fractal::Tile_range{message.header.header.identifier,
+                                   cancel_token,
+                                   on_task_completed,
+                                   on_task_canceled,
+                                   fractal_view,
+                                   tile_size,
+                                   tile_size};
+
+  // Tiles are published as they complete, the middle of the view, where the viewer is looking, goes out first.
+  tiles.order(Fractal::Tile_order::centre_out);
+
+  // The render is submitted rather than invoked, so the next message is handled while it runs.
+  auto render = Fractal::Render_handle{};
+  if (message.deep_zoom)
+  {
+    // The complex view is relative to the reference point, past what doubles can resolve on their own.  Its orbit is
+    // iterated by the first tile, on the workers and under the cancel token of the request, so this thread is free
+    // for the next message.
+    auto function = Fractal::Perturbation_function{message.reference_real, message.reference_imaginary, fractal_view, message.max_iterations};
+    render = m_generator.submit(function, tiles);
+  }
+  else if (message.supersampling > 1)
+  {
+    // Antialiased, only the pixels close to the boundary of the set are supersampled.
+    auto function = Fractal::Distance_estimation_function{message.max_iterations};
+    function.set_samples(message.supersampling);
+    function.set_pixel_spacing(fractal_view);
+    render = m_generator.submit(function, tiles);
+  }
+  else
+  {
+    auto function = Fractal::Mandlebrot_function{message.max_iterations};
+    render = m_generator.submit(function, tiles);
+  }
 
+  auto identifier = message.header.header.identifier;
   {
     std::lock_guard<std::mutex> lk{m_mutex};
-    m_cancel_tokens.emplace(std::make_pair(message.header.header.identifier, cancel_token));
+    m_renders[identifier] = render;
   }
 
-  auto function = Fractal::Mandlebrot_function{message.max_iterations};
-  m_generator(function, task_parameters);
-
+  // A later request with the same identifier may have replaced this render by the time it finishes, its handle is
+  // left alone.
+  render.then([this, identifier, render]()
   {
     std::lock_guard<std::mutex> lk{m_mutex};
-    m_cancel_tokens.erase(message.header.header.identifier);
-  }                                                              
+    auto it = m_renders.find(identifier);
+    if (it != std::end(m_renders) && it->second == render)
+    {
+      m_renders.erase(it);
+    }
+  });
 
   return awsiotsdk::ResponseCode::SUCCESS;
 }
@@ -109,11 +148,12 @@ awsiotsdk::ResponseCode Subscriber::handle_cancel_message_(const awsiotsdk::util
   std::cout << "****** RECEIVED CANCEL MESSAGE ******" << std::endl;
   Fractal::print(std::cout, message);
 
-  auto it = m_cancel_tokens.find(message.header.identifier);
-  if (it != std::end(m_cancel_tokens))
+  std::lock_guard<std::mutex> lk{m_mutex};
+  auto it = m_renders.find(message.header.identifier);
+  if (it != std::end(m_renders))
   {
-    it->second->store(true);
-    m_cancel_tokens.erase(it);
+    it->second.cancel();
+    m_renders.erase(it);
   }
 
   return awsiotsdk::ResponseCode::SUCCESS;
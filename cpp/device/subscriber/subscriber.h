@@ -6,6 +6,7 @@
 #include "messages.h"
 #include "mqtt/Client.hpp"
 #include "NetworkConnection.hpp"
+#include "render_handle.h"
 #include "task_parameters.h"
 
 namespace Onboarding
@@ -28,7 +29,7 @@ protected:
   awsiotsdk::ResponseCode unsubscribe_();
   awsiotsdk::ResponseCode initialize_TLS_();
 
-  awsiotsdk::ResponseCode publish_response_message_(const Fractal::Response_message& message);
+  awsiotsdk::ResponseCode publish_response_message_(const Fractal::Response_view& message);
   awsiotsdk::ResponseCode subscribe_callback_(awsiotsdk::util::String topic_name,
                                               awsiotsdk::util::String payload,
                                               std::shared_ptr<awsiotsdk::mqtt::SubscriptionHandlerContextData> app_handler_data);
@@ -49,7 +50,7 @@ private:
   std::shared_ptr<awsiotsdk::MqttClient> m_iot_client;
   std::shared_ptr<awsiotsdk::NetworkConnection> m_network_connection;
   std::mutex m_mutex;
-  std::unordered_map<std::string, std::shared_ptr<std::atomic<bool>>> m_cancel_tokens;
-  Fractal::Distributed_generator m_generator{3};
+  std::unordered_map<std::string, Fractal::Render_handle> m_renders;
+  Fractal::Distributed_generator m_generator;
 };
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+//
+//  adaptive_mandlebrot_function.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef adaptive_mandlebrot_function_h
+#define adaptive_mandlebrot_function_h
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "extended_mandlebrot_function.h"
+#include "extended_precision.h"
+#include "mandlebrot_function.h"
+#include "precision.h"
+
+namespace Fractal
+{
+
+// Mandlebrot_function that iterates each tile with the cheapest precision that still resolves its pixels.  Shallow
+// tiles run in float, twice as many lanes per vector as double, and tiles too deep for doubles fall back on
+// Double_double or Quad_double.  Distributed_generator sets the precision the resolution of the tile and the
+// iterations call for (see select_precision) before invoking it, and hands invoke_tile Quad_double tables that are
+// narrowed to that precision.
+class Adaptive_mandlebrot_function final
+{
+public:
+  using Coordinate = Quad_double;
+
+  Adaptive_mandlebrot_function() = default;
+  Adaptive_mandlebrot_function(size_t max_iterations)
+  : m_function{max_iterations},
+    m_double_double_function{max_iterations},
+    m_quad_double_function{max_iterations}
+  {
+  }
+  Adaptive_mandlebrot_function(const Adaptive_mandlebrot_function&) = default;
+  Adaptive_mandlebrot_function(Adaptive_mandlebrot_function&&) = default;
+  ~Adaptive_mandlebrot_function() = default;
+
+  Adaptive_mandlebrot_function& operator=(const Adaptive_mandlebrot_function&) = default;
+  Adaptive_mandlebrot_function& operator=(Adaptive_mandlebrot_function&&) = default;
+
+  // Evaluates a width x height tile, pixel (x, y) being real[x] + imaginary[y] * i and landing in argb[x + y * stride].
+  void invoke_tile(const Quad_double* real,
+                   size_t width,
+                   const Quad_double* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    iterate_tile(real, width, imaginary, height, argb, nullptr, stride, cancel_token);
+    m_function.color_table()->invoke_tile(argb, nullptr, width, height, stride, argb, stride);
+  }
+
+  // Escape counts of a width x height tile, see Mandlebrot_function::iterate_tile.
+  template <typename Count>
+  void iterate_tile(const Quad_double* real,
+                    size_t width,
+                    const Quad_double* imaginary,
+                    size_t height,
+                    Count* iterations,
+                    float* smooth,
+                    size_t stride,
+                    const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    switch (m_precision)
+    {
+      case Precision::float32:
+        iterate_tile_<float>(m_function, real, width, imaginary, height, iterations, smooth, stride, cancel_token);
+        break;
+      case Precision::double_double:
+        iterate_tile_<Double_double>(m_double_double_function, real, width, imaginary, height, iterations, smooth, stride, cancel_token);
+        break;
+      case Precision::quad_double:
+        m_quad_double_function.iterate_tile(real, width, imaginary, height, iterations, smooth, stride, cancel_token);
+        break;
+      default:
+        iterate_tile_<double>(m_function, real, width, imaginary, height, iterations, smooth, stride, cancel_token);
+        break;
+    }
+  }
+
+  Precision precision() const
+  {
+    return m_precision;
+  }
+
+  // Precision the next tiles are iterated with.
+  void set_precision(Precision precision)
+  {
+    m_precision = precision;
+  }
+
+  Symmetry symmetry() const
+  {
+    return m_function.symmetry();
+  }
+
+  size_t max_iterations() const
+  {
+    return m_function.max_iterations();
+  }
+
+  void set_max_iterations(size_t iterations)
+  {
+    m_function.set_max_iterations(iterations);
+    m_double_double_function.set_max_iterations(iterations);
+    m_quad_double_function.set_max_iterations(iterations);
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_function.colormap();
+  }
+
+  void set_colormap(const Colormap& colormap)
+  {
+    m_function.set_colormap(colormap);
+    m_double_double_function.set_colormap(colormap);
+    m_quad_double_function.set_colormap(colormap);
+  }
+
+  // Colors escape counts whatever the precision they were computed with.
+  const std::shared_ptr<const Color_table>& color_table() const
+  {
+    return m_function.color_table();
+  }
+
+  // Mandlebrot_function used for the float and double tiles, to configure its interior test, streaming or
+  // periodicity checking.
+  Mandlebrot_function& function()
+  {
+    return m_function;
+  }
+
+  const Mandlebrot_function& function() const
+  {
+    return m_function;
+  }
+
+  const std::shared_ptr<Precision_statistics>& precision_statistics() const
+  {
+    return m_precision_statistics;
+  }
+
+  // Tiles and pixels computed at each precision, shared by every copy of this function the generator makes.  The
+  // generator records each tile once, as it picks its precision.
+  void set_precision_statistics(std::shared_ptr<Precision_statistics> precision_statistics)
+  {
+    m_precision_statistics = std::move(precision_statistics);
+  }
+
+  void set_lane_statistics(std::shared_ptr<Lane_statistics> lane_statistics)
+  {
+    m_function.set_lane_statistics(lane_statistics);
+    m_double_double_function.set_lane_statistics(lane_statistics);
+    m_quad_double_function.set_lane_statistics(std::move(lane_statistics));
+  }
+
+private:
+  template <typename Number, typename Function, typename Count>
+  static void iterate_tile_(const Function& function,
+                            const Quad_double* real,
+                            size_t width,
+                            const Quad_double* imaginary,
+                            size_t height,
+                            Count* iterations,
+                            float* smooth,
+                            size_t stride,
+                            const std::shared_ptr<std::atomic<bool>>& cancel_token)
+  {
+    auto narrow_real = std::vector<Number>(width);
+    auto narrow_imaginary = std::vector<Number>(height);
+    for (size_t x = 0; x < width; ++x)
+    {
+      narrow_real[x] = Extended_precision_traits<Number>::from(real[x]);
+    }
+    for (size_t y = 0; y < height; ++y)
+    {
+      narrow_imaginary[y] = Extended_precision_traits<Number>::from(imaginary[y]);
+    }
+
+    function.iterate_tile(narrow_real.data(), width, narrow_imaginary.data(), height, iterations, smooth, stride, cancel_token);
+  }
+
+private:
+  Mandlebrot_function m_function;
+  Double_double_mandlebrot_function m_double_double_function;
+  Quad_double_mandlebrot_function m_quad_double_function;
+  Precision m_precision{Precision::float64};
+  std::shared_ptr<Precision_statistics> m_precision_statistics;
+};
+
+}
+
+#endif /* adaptive_mandlebrot_function_h */
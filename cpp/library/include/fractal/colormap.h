@@ -0,0 +1,216 @@
+//
+//  colormap.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef colormap_h
+#define colormap_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Fractal
+{
+
+// Colors escape counts are mapped to.  The palette is stretched over [0, max_iterations), pixels that never escaped
+// get the interior color.  Without a palette the smooth polynomials the functions always used are evaluated instead.
+class Colormap final
+{
+public:
+  // Value is part of the Mandlebrot set, let's just represent that by the color black
+  static constexpr uint32_t black = 0xFF000000;
+
+  Colormap() = default;
+  Colormap(std::vector<uint32_t> colors, uint32_t interior = black)
+  : m_colors{std::move(colors)},
+    m_interior{interior}
+  {
+  }
+  Colormap(const Colormap&) = default;
+  Colormap(Colormap&&) = default;
+  ~Colormap() = default;
+
+  Colormap& operator=(const Colormap&) = default;
+  Colormap& operator=(Colormap&&) = default;
+
+  // Color of the escape count iteration out of iterations.
+  uint32_t invoke(size_t iteration, size_t iterations) const
+  {
+    if (iteration >= iterations)
+    {
+      return m_interior;
+    }
+
+    if (m_colors.empty())
+    {
+      return polynomial_(iteration, iterations);
+    }
+
+    return m_colors[iteration * m_colors.size() / iterations];
+  }
+
+  uint32_t operator()(size_t iteration, size_t iterations) const
+  {
+    return invoke(iteration, iterations);
+  }
+
+  const std::vector<uint32_t>& colors() const
+  {
+    return m_colors;
+  }
+
+  uint32_t interior() const
+  {
+    return m_interior;
+  }
+
+private:
+  static uint32_t polynomial_(size_t iteration, size_t iterations)
+  {
+    auto t = static_cast<double>(iteration) / static_cast<double>(iterations);
+
+    // Use smooth polynomials for r, g, b
+    auto r = static_cast<int8_t>(9*(1-t)*t*t*t*255);
+    auto g = static_cast<int8_t>(15*(1-t)*(1-t)*t*t*255);
+    auto b = static_cast<int8_t>(8.5*(1-t)*(1-t)*(1-t)*t*255);
+    return (0xff << 24) | (r << 16) | (g << 8) | b;
+  }
+
+private:
+  std::vector<uint32_t> m_colors;
+  uint32_t m_interior{black};
+};
+
+// Colormap expanded to one entry per escape count for a given max_iterations, so coloring a pixel is a single
+// table load.  Functions keep their iteration counts apart from the colors, a view is colored (or recolored) by
+// running its counts through a table.
+class Color_table final
+{
+public:
+  Color_table()
+  : Color_table{Colormap{}, 64}
+  {
+  }
+  Color_table(Colormap colormap, size_t max_iterations)
+  : m_colormap{std::move(colormap)},
+    m_max_iterations{max_iterations},
+    m_table(max_iterations + 1)
+  {
+    for (size_t i = 0; i <= max_iterations; ++i)
+    {
+      m_table[i] = m_colormap(i, max_iterations);
+    }
+  }
+  Color_table(const Color_table&) = default;
+  Color_table(Color_table&&) = default;
+  ~Color_table() = default;
+
+  Color_table& operator=(const Color_table&) = default;
+  Color_table& operator=(Color_table&&) = default;
+
+  uint32_t invoke(size_t iteration) const
+  {
+    return m_table[std::min(iteration, m_max_iterations)];
+  }
+
+  uint32_t operator()(size_t iteration) const
+  {
+    return invoke(iteration);
+  }
+
+  // Color of a fractional escape count (see Escape_time_kernel::smooth_iterations), blended channel by channel
+  // between the two counts around it.
+  uint32_t invoke_smooth(float smooth) const
+  {
+    if (!(smooth < static_cast<float>(m_max_iterations)))
+    {
+      return m_table[m_max_iterations];
+    }
+
+    auto position = std::max(smooth, 0.0f);
+    auto index = static_cast<size_t>(position);
+    auto fraction = static_cast<uint32_t>((position - static_cast<float>(index)) * 256.0f);
+
+    // The last escaped count doesn't blend into the interior color.
+    auto from = m_table[index];
+    auto to = m_table[std::min(index + 1, m_max_iterations - 1)];
+    auto color = uint32_t{0};
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+      auto a = (from >> shift) & 0xFF;
+      auto b = (to >> shift) & 0xFF;
+      color |= (((a * (256 - fraction) + b * fraction) >> 8) & 0xFF) << shift;
+    }
+    return color;
+  }
+
+  // Colors count pixels.  iterations and argb may be the same buffer, the table is indexed branch free so the loop
+  // vectorizes into gathers.
+  template <typename Count>
+  void invoke(const Count* iterations, size_t count, uint32_t* argb) const
+  {
+    const auto* table = m_table.data();
+    const auto limit = static_cast<uint32_t>(m_max_iterations);
+    for (size_t n = 0; n < count; ++n)
+    {
+      argb[n] = table[std::min(static_cast<uint32_t>(iterations[n]), limit)];
+    }
+  }
+
+  // Same as above from fractional counts, pixels that never escaped are told apart by their iteration count.
+  template <typename Count>
+  void invoke(const Count* iterations, const float* smooth, size_t count, uint32_t* argb) const
+  {
+    if (!smooth)
+    {
+      invoke(iterations, count, argb);
+      return;
+    }
+
+    for (size_t n = 0; n < count; ++n)
+    {
+      argb[n] = iterations[n] >= m_max_iterations ? m_table[m_max_iterations] : invoke_smooth(smooth[n]);
+    }
+  }
+
+  // Colors a width x height tile, pixel (x, y) being read from iterations[x + y * stride] (and smooth when it isn't
+  // null) and landing in argb[x + y * argb_stride].
+  template <typename Count>
+  void invoke_tile(const Count* iterations,
+                   const float* smooth,
+                   size_t width,
+                   size_t height,
+                   size_t stride,
+                   uint32_t* argb,
+                   size_t argb_stride) const
+  {
+    for (size_t y = 0; y < height; ++y)
+    {
+      invoke(iterations + y * stride, smooth ? smooth + y * stride : nullptr, width, argb + y * argb_stride);
+    }
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_colormap;
+  }
+
+  size_t max_iterations() const
+  {
+    return m_max_iterations;
+  }
+
+private:
+  Colormap m_colormap;
+  size_t m_max_iterations{64};
+  std::vector<uint32_t> m_table;
+};
+
+}
+
+#endif /* colormap_h */
@@ -0,0 +1,329 @@
+//
+//  cost_map.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef cost_map_h
+#define cost_map_h
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "fractal_view.h"
+#include "interior_test.h"
+
+namespace Fractal
+{
+
+// How expensive each part of a view is to render, kept per pixel on a grid of cells of cell_size x cell_size
+// pixels.  The costs come from a probe at low resolution before the render or from the time the tasks of the
+// previous frame took (see Distributed_generator::set_cost_map).  Generator_task_parameters::distribute cuts views into tiles of
+// about the same cost with it.  A map made for one view estimates the cost of another by its complex coordinates,
+// so the timings of a frame still guide the next one once it was scrolled or zoomed; the parts of the new view the
+// map doesn't cover are taken to cost the average.
+class Cost_map final
+{
+public:
+  Cost_map() = default;
+  Cost_map(Fractal_view::Pixel_view pixel_view, Fractal_view::Complex_view complex_view, size_t cell_size = s_cell_size)
+  : m_pixel_view{std::move(pixel_view)},
+    m_complex_view{std::move(complex_view)},
+    m_cell_size{std::max(cell_size, size_t{1})},
+    m_columns{(m_pixel_view.width() + m_cell_size - 1) / m_cell_size},
+    m_rows{(m_pixel_view.height() + m_cell_size - 1) / m_cell_size},
+    m_costs(m_columns * m_rows, 0.0)
+  {
+  }
+  Cost_map(const Fractal_view& view, size_t cell_size = s_cell_size)
+  : Cost_map{view.pixel_view(), view.complex_view(), cell_size}
+  {
+  }
+  Cost_map(const Cost_map& other)
+  : m_pixel_view{other.m_pixel_view},
+    m_complex_view{other.m_complex_view},
+    m_cell_size{other.m_cell_size},
+    m_columns{other.m_columns},
+    m_rows{other.m_rows},
+    m_costs{other.costs_()}
+  {
+  }
+  Cost_map(Cost_map&& other)
+  : Cost_map{static_cast<const Cost_map&>(other)}
+  {
+  }
+  ~Cost_map() = default;
+
+  Cost_map& operator=(const Cost_map& other)
+  {
+    if (this != &other)
+    {
+      auto costs = other.costs_();
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_pixel_view = other.m_pixel_view;
+      m_complex_view = other.m_complex_view;
+      m_cell_size = other.m_cell_size;
+      m_columns = other.m_columns;
+      m_rows = other.m_rows;
+      m_costs = std::move(costs);
+    }
+    return *this;
+  }
+  Cost_map& operator=(Cost_map&& other)
+  {
+    return *this = static_cast<const Cost_map&>(other);
+  }
+
+  // Costs the centre of each cell with the escape time of the Mandlebrot set, the interior test resolving the points
+  // it can for next to nothing like the functions do.  The cost of the other functions of the family is distributed
+  // much the same.  A cell of 16 x 16 pixels probes a 256th of the view.
+  static Cost_map probe(const Fractal_view& view, size_t max_iterations, size_t cell_size = s_cell_size)
+  {
+    auto interior_test = Interior_test{};
+    return sample(view, [&](std::complex<double> c)
+    {
+      if (interior_test(c) != Interior_region::none)
+      {
+        return 1.0;
+      }
+
+      auto z = std::complex<double>{};
+      for (size_t i = 0; i < max_iterations; ++i)
+      {
+        if (std::norm(z) > 4.0)
+        {
+          return static_cast<double>(i + 1);
+        }
+        z = z * z + c;
+      }
+      return static_cast<double>(max_iterations + 1);
+    }, cell_size);
+  }
+
+  // Costs the centre of each cell with cost(c), which is taken to be the cost of every pixel of the cell.
+  template <typename Cost>
+  static Cost_map sample(const Fractal_view& view, Cost cost, size_t cell_size = s_cell_size)
+  {
+    auto map = Cost_map{view, cell_size};
+    for (size_t row = 0; row < map.m_rows; ++row)
+    {
+      for (size_t column = 0; column < map.m_columns; ++column)
+      {
+        auto cell = map.cell_(column, row);
+        auto x = 0.5 * static_cast<double>(cell.left + cell.right);
+        auto y = 0.5 * static_cast<double>(cell.top + cell.bottom);
+        map.m_costs[column + row * map.m_columns] = cost(map.complex_(x, y));
+      }
+    }
+    return map;
+  }
+
+  bool empty() const
+  {
+    return m_costs.empty();
+  }
+
+  const Fractal_view::Pixel_view& pixel_view() const
+  {
+    return m_pixel_view;
+  }
+
+  const Fractal_view::Complex_view& complex_view() const
+  {
+    return m_complex_view;
+  }
+
+  // Adds cost spread evenly over the pixels of rectangle.  Safe to call from several tasks at once.
+  void record(const Fractal_view::Pixel_view& rectangle, double cost)
+  {
+    auto area = static_cast<double>(rectangle.width() * rectangle.height());
+    if (area == 0.0 || m_costs.empty())
+    {
+      return;
+    }
+
+    auto left = std::max(rectangle.left, m_pixel_view.left);
+    auto top = std::max(rectangle.top, m_pixel_view.top);
+    auto right = std::min(rectangle.right, m_pixel_view.right);
+    auto bottom = std::min(rectangle.bottom, m_pixel_view.bottom);
+    if (left >= right || top >= bottom)
+    {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (auto row = (top - m_pixel_view.top) / m_cell_size; row * m_cell_size + m_pixel_view.top < bottom; ++row)
+    {
+      for (auto column = (left - m_pixel_view.left) / m_cell_size; column * m_cell_size + m_pixel_view.left < right; ++column)
+      {
+        auto cell = cell_(column, row);
+        auto overlap = Fractal_view::Pixel_view{std::max(cell.left, left),
+                                                std::max(cell.top, top),
+                                                std::min(cell.right, right),
+                                                std::min(cell.bottom, bottom)};
+        m_costs[column + row * m_columns] += cost * static_cast<double>(overlap.width() * overlap.height())
+                                             / (area * static_cast<double>(cell.width() * cell.height()));
+      }
+    }
+  }
+
+  // Estimated cost of the pixels of view inside rectangle.
+  double cost(const Fractal_view& view, const Fractal_view::Pixel_view& rectangle) const
+  {
+    auto pixel_count = static_cast<double>(rectangle.width() * rectangle.height());
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_costs.empty() || pixel_count == 0.0)
+    {
+      return 0.0;
+    }
+
+    if (view.pixel_view() == m_pixel_view && view.complex_view() == m_complex_view)
+    {
+      return cost_(static_cast<double>(rectangle.left),
+                   static_cast<double>(rectangle.top),
+                   static_cast<double>(rectangle.right),
+                   static_cast<double>(rectangle.bottom));
+    }
+
+    // Where the corners of the rectangle fall on the pixels of the map.
+    const auto& pixels = view.pixel_view();
+    const auto& complex = view.complex_view();
+    auto real_factor = (complex.right - complex.left) / static_cast<double>(pixels.width());
+    auto imaginary_factor = (complex.bottom - complex.top) / static_cast<double>(pixels.height());
+    auto x = [&](size_t pixel)
+    {
+      return x_(complex.left + static_cast<double>(pixel - pixels.left) * real_factor);
+    };
+    auto y = [&](size_t pixel)
+    {
+      return y_(complex.top + static_cast<double>(pixel - pixels.top) * imaginary_factor);
+    };
+    auto left = x(rectangle.left);
+    auto right = x(rectangle.right);
+    auto top = y(rectangle.top);
+    auto bottom = y(rectangle.bottom);
+    auto area = (right - left) * (bottom - top);
+    if (!std::isfinite(area) || area <= 0.0)
+    {
+      return average_() * pixel_count;
+    }
+
+    // Per pixel of view rather than of the map.
+    return cost_(left, top, right, bottom) * pixel_count / area;
+  }
+
+private:
+  static constexpr size_t s_cell_size = 16;
+
+  Fractal_view::Pixel_view cell_(size_t column, size_t row) const
+  {
+    auto left = m_pixel_view.left + column * m_cell_size;
+    auto top = m_pixel_view.top + row * m_cell_size;
+    return Fractal_view::Pixel_view{left,
+                                    top,
+                                    std::min(left + m_cell_size, m_pixel_view.right),
+                                    std::min(top + m_cell_size, m_pixel_view.bottom)};
+  }
+
+  std::complex<double> complex_(double x, double y) const
+  {
+    auto real_factor = (m_complex_view.right - m_complex_view.left) / static_cast<double>(m_pixel_view.width());
+    auto imaginary_factor = (m_complex_view.bottom - m_complex_view.top) / static_cast<double>(m_pixel_view.height());
+    return {m_complex_view.left + (x - static_cast<double>(m_pixel_view.left)) * real_factor,
+            m_complex_view.top + (y - static_cast<double>(m_pixel_view.top)) * imaginary_factor};
+  }
+
+  double x_(double real) const
+  {
+    auto factor = static_cast<double>(m_pixel_view.width()) / (m_complex_view.right - m_complex_view.left);
+    return static_cast<double>(m_pixel_view.left) + (real - m_complex_view.left) * factor;
+  }
+
+  double y_(double imaginary) const
+  {
+    auto factor = static_cast<double>(m_pixel_view.height()) / (m_complex_view.bottom - m_complex_view.top);
+    return static_cast<double>(m_pixel_view.top) + (imaginary - m_complex_view.top) * factor;
+  }
+
+  // Cost of the map's pixels from (left, top) to (right, bottom), the part off the map at the average.
+  double cost_(double left, double top, double right, double bottom) const
+  {
+    auto cell_size = static_cast<double>(m_cell_size);
+    auto view_left = static_cast<double>(m_pixel_view.left);
+    auto view_top = static_cast<double>(m_pixel_view.top);
+    auto view_right = static_cast<double>(m_pixel_view.right);
+    auto view_bottom = static_cast<double>(m_pixel_view.bottom);
+    auto inside_left = std::max(left, view_left);
+    auto inside_top = std::max(top, view_top);
+    auto inside_right = std::min(right, view_right);
+    auto inside_bottom = std::min(bottom, view_bottom);
+
+    auto total = 0.0;
+    auto inside = 0.0;
+    if (inside_left < inside_right && inside_top < inside_bottom)
+    {
+      auto first_column = static_cast<size_t>((inside_left - view_left) / cell_size);
+      auto first_row = static_cast<size_t>((inside_top - view_top) / cell_size);
+      for (auto row = first_row; row < m_rows && view_top + static_cast<double>(row) * cell_size < inside_bottom; ++row)
+      {
+        auto cell_top = std::max(inside_top, view_top + static_cast<double>(row) * cell_size);
+        auto cell_bottom = std::min(inside_bottom, view_top + static_cast<double>(row + 1) * cell_size);
+        for (auto column = first_column; column < m_columns && view_left + static_cast<double>(column) * cell_size < inside_right; ++column)
+        {
+          auto cell_left = std::max(inside_left, view_left + static_cast<double>(column) * cell_size);
+          auto cell_right = std::min(inside_right, view_left + static_cast<double>(column + 1) * cell_size);
+          auto overlap = (cell_right - cell_left) * (cell_bottom - cell_top);
+          total += overlap * m_costs[column + row * m_columns];
+        }
+      }
+      inside = (inside_right - inside_left) * (inside_bottom - inside_top);
+    }
+
+    auto outside = (right - left) * (bottom - top) - inside;
+    if (outside > 0.0)
+    {
+      total += outside * average_();
+    }
+    return total;
+  }
+
+  // Cost of a pixel on average.
+  double average_() const
+  {
+    auto total = 0.0;
+    for (size_t row = 0; row < m_rows; ++row)
+    {
+      for (size_t column = 0; column < m_columns; ++column)
+      {
+        auto cell = cell_(column, row);
+        total += m_costs[column + row * m_columns] * static_cast<double>(cell.width() * cell.height());
+      }
+    }
+    return total / static_cast<double>(m_pixel_view.width() * m_pixel_view.height());
+  }
+
+  std::vector<double> costs_() const
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_costs;
+  }
+
+private:
+  Fractal_view::Pixel_view m_pixel_view{};
+  Fractal_view::Complex_view m_complex_view{};
+  size_t m_cell_size{s_cell_size};
+  size_t m_columns{0};
+  size_t m_rows{0};
+  std::vector<double> m_costs;
+  mutable std::mutex m_mutex;
+};
+
+}
+
+#endif /* cost_map_h */
@@ -0,0 +1,453 @@
+//
+//  distance_estimation_function.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef distance_estimation_function_h
+#define distance_estimation_function_h
+
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+
+#include "colormap.h"
+#include "escape_time_kernel.h"
+#include "fractal_view.h"
+#include "interior_test.h"
+#include "symmetry.h"
+
+namespace Fractal
+{
+
+// Counts how many of the pixels a Distance_estimation_function rendered it had to supersample.
+struct Supersampling_statistics
+{
+  std::atomic<uint64_t> pixels{0};
+  std::atomic<uint64_t> supersampled_pixels{0};
+
+  double fraction() const
+  {
+    auto total = pixels.load();
+    if (total == 0)
+    {
+      return 0.0;
+    }
+    return static_cast<double>(supersampled_pixels.load()) / static_cast<double>(total);
+  }
+
+  void reset()
+  {
+    pixels = 0;
+    supersampled_pixels = 0;
+  }
+};
+
+// Antialiased Mandlebrot or Julia set that only supersamples where it matters.  Every pixel is first evaluated once
+// through Escape_time_kernel::invoke_distance, which also estimates how far the pixel lies from the set.  Pixels
+// closer to the boundary than the distance threshold, and interior pixels next to an escaped one, are then
+// evaluated again on a samples x samples grid spread over the pixel and get the average color.  Pixels far from
+// the boundary keep the color of their single sample, so the cost grows with the length of the boundary in the
+// view rather than with its area.
+class Distance_estimation_function final
+{
+public:
+  Distance_estimation_function() = default;
+  Distance_estimation_function(size_t max_iterations)
+  : m_max_iterations{max_iterations}
+  {
+  }
+  // The Julia set of z^2 + k.
+  Distance_estimation_function(std::complex<double> k, size_t max_iterations)
+  : m_julia{true},
+    m_k{std::move(k)},
+    m_max_iterations{max_iterations}
+  {
+  }
+  Distance_estimation_function(const Distance_estimation_function&) = default;
+  Distance_estimation_function(Distance_estimation_function&&) = default;
+  ~Distance_estimation_function() = default;
+
+  Distance_estimation_function& operator=(const Distance_estimation_function&) = default;
+  Distance_estimation_function& operator=(Distance_estimation_function&&) = default;
+
+  uint32_t invoke(std::complex<double> z, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    auto real = z.real();
+    auto imaginary = z.imag();
+    auto argb = uint32_t{0};
+    invoke_tile(&real, 1, &imaginary, 1, &argb, 1, cancel_token);
+    return argb;
+  }
+
+  uint32_t operator()(std::complex<double> z, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    return invoke(std::move(z), cancel_token);
+  }
+
+  // Evaluates a width x height tile, pixel (x, y) being real[x] + imaginary[y] * i and landing in argb[x + y * stride].
+  // The neighbours of the edge pixels are taken pixel_spacing() away, so the tile is evaluated with a one pixel
+  // apron around it.
+  void invoke_tile(const double* real,
+                   size_t width,
+                   const double* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    if (width == 0 || height == 0)
+    {
+      return;
+    }
+
+    const auto apron_width = width + 2;
+    const auto apron_height = height + 2;
+    auto apron_real = std::vector<double>(apron_width);
+    auto apron_imaginary = std::vector<double>(apron_height);
+    apron_real.front() = real[0] - m_pixel_spacing;
+    std::copy(real, real + width, apron_real.begin() + 1);
+    apron_real.back() = real[width - 1] + m_pixel_spacing;
+    apron_imaginary.front() = imaginary[0] - m_pixel_spacing;
+    std::copy(imaginary, imaginary + height, apron_imaginary.begin() + 1);
+    apron_imaginary.back() = imaginary[height - 1] + m_pixel_spacing;
+
+    auto iterations = std::vector<uint32_t>(apron_width * apron_height);
+    auto distance = std::vector<float>(apron_width * apron_height);
+    for (size_t y = 0; y < apron_height; ++y)
+    {
+      iterate_row_(apron_real.data(),
+                   apron_imaginary[y],
+                   apron_width,
+                   iterations.data() + y * apron_width,
+                   distance.data() + y * apron_width,
+                   *cancel_token);
+    }
+
+    const auto threshold = static_cast<float>(m_distance_threshold * m_pixel_spacing);
+    auto supersampled = std::vector<size_t>{};
+    auto supersampled_count = uint64_t{0};
+    for (size_t y = 0; y < height; ++y)
+    {
+      if (cancel_token->load())
+      {
+        return;
+      }
+
+      supersampled.clear();
+      for (size_t x = 0; x < width; ++x)
+      {
+        auto index = x + 1 + (y + 1) * apron_width;
+        if (m_samples > 1 && near_boundary_(iterations.data(), distance.data(), index, apron_width, threshold))
+        {
+          supersampled.push_back(x);
+          continue;
+        }
+
+        argb[x + y * stride] = (*m_color_table)(iterations[index]);
+      }
+
+      supersample_(real, imaginary[y], supersampled, argb + y * stride, *cancel_token);
+      supersampled_count += supersampled.size();
+    }
+
+    if (m_supersampling_statistics)
+    {
+      m_supersampling_statistics->pixels += width * height;
+      m_supersampling_statistics->supersampled_pixels += supersampled_count;
+    }
+  }
+
+  // The samples are placed symmetrically within each pixel, so the image keeps the symmetry of the set.
+  Symmetry symmetry() const
+  {
+    return m_julia ? Symmetry::origin : Symmetry::real_axis;
+  }
+
+  size_t max_iterations() const
+  {
+    return m_max_iterations;
+  }
+
+  void set_max_iterations(size_t iterations)
+  {
+    m_max_iterations = iterations;
+    m_color_table = std::make_shared<const Color_table>(m_color_table->colormap(), m_max_iterations);
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_color_table->colormap();
+  }
+
+  void set_colormap(Colormap colormap)
+  {
+    m_color_table = std::make_shared<const Color_table>(std::move(colormap), m_max_iterations);
+  }
+
+  // Colors escape counts, shared by the copies of the function.
+  const std::shared_ptr<const Color_table>& color_table() const
+  {
+    return m_color_table;
+  }
+
+  size_t samples() const
+  {
+    return m_samples;
+  }
+
+  // Samples per side of the grid a pixel close to the boundary is supersampled with, one disables supersampling.
+  void set_samples(size_t samples)
+  {
+    m_samples = std::max(samples, size_t{1});
+  }
+
+  double pixel_spacing() const
+  {
+    return m_pixel_spacing;
+  }
+
+  // Distance between neighbouring pixels of the view being rendered, which places the samples and scales the
+  // distance threshold.
+  void set_pixel_spacing(double pixel_spacing)
+  {
+    m_pixel_spacing = pixel_spacing;
+  }
+
+  void set_pixel_spacing(const Fractal_view& fractal_view)
+  {
+    m_pixel_spacing = fractal_view.pixel_spacing();
+  }
+
+  double distance_threshold() const
+  {
+    return m_distance_threshold;
+  }
+
+  // Pixels whose estimated distance to the set is below this many pixels are supersampled.
+  void set_distance_threshold(double pixels)
+  {
+    m_distance_threshold = pixels;
+  }
+
+  const Interior_test& interior_test() const
+  {
+    return m_interior_test;
+  }
+
+  // Applies to the Mandlebrot set only, both the single samples and the supersamples it resolves skip the kernel.
+  void set_interior_test(Interior_test interior_test)
+  {
+    m_interior_test = std::move(interior_test);
+  }
+
+  const std::shared_ptr<Supersampling_statistics>& supersampling_statistics() const
+  {
+    return m_supersampling_statistics;
+  }
+
+  // Copies of the function share the statistics, so one instance can collect how much of a whole render was
+  // supersampled.
+  void set_supersampling_statistics(std::shared_ptr<Supersampling_statistics> supersampling_statistics)
+  {
+    m_supersampling_statistics = std::move(supersampling_statistics);
+  }
+
+  const std::shared_ptr<Lane_statistics>& lane_statistics() const
+  {
+    return m_lane_statistics;
+  }
+
+  void set_lane_statistics(std::shared_ptr<Lane_statistics> lane_statistics)
+  {
+    m_lane_statistics = std::move(lane_statistics);
+  }
+
+private:
+  const std::complex<double>* k_() const
+  {
+    return m_julia ? &m_k : nullptr;
+  }
+
+  bool interior_test_enabled_() const
+  {
+    return !m_julia && m_interior_test.enabled();
+  }
+
+  // Single sample of each pixel of a row with its distance estimate.  Only the runs of pixels the interior test
+  // couldn't resolve go through the kernel.
+  void iterate_row_(const double* real,
+                    double imaginary,
+                    size_t count,
+                    uint32_t* iterations,
+                    float* distance,
+                    const std::atomic<bool>& cancel_token) const
+  {
+    auto kernel = Escape_time_kernel{};
+    if (!interior_test_enabled_())
+    {
+      kernel.invoke_distance(real, count, &imaginary, 1, k_(), m_max_iterations, iterations, distance, count, cancel_token, m_lane_statistics.get());
+      return;
+    }
+
+    classify_(real, imaginary, count, iterations, distance);
+
+    for (size_t n = 0; n < count;)
+    {
+      if (iterations[n] != Escape_time_kernel::pending)
+      {
+        ++n;
+        continue;
+      }
+
+      auto end = n;
+      while (end < count && iterations[end] == Escape_time_kernel::pending)
+      {
+        ++end;
+      }
+
+      kernel.invoke_distance(real + n,
+                             end - n,
+                             &imaginary,
+                             1,
+                             k_(),
+                             m_max_iterations,
+                             iterations + n,
+                             distance + n,
+                             end - n,
+                             cancel_token,
+                             m_lane_statistics.get());
+      n = end;
+    }
+  }
+
+  // Writes max_iterations for the pixels the interior test resolves and Escape_time_kernel::pending for the others.
+  void classify_(const double* real, double imaginary, size_t count, uint32_t* iterations, float* distance) const
+  {
+    uint64_t counts[4] = {};
+    for (size_t n = 0; n < count; ++n)
+    {
+      auto region = m_interior_test(std::complex<double>{real[n], imaginary});
+      ++counts[static_cast<size_t>(region)];
+      iterations[n] = region == Interior_region::none ? Escape_time_kernel::pending : static_cast<uint32_t>(m_max_iterations);
+      if (distance)
+      {
+        distance[n] = 0.0f;
+      }
+    }
+    m_interior_test.record(counts);
+  }
+
+  // Exterior pixels are close when their estimate is below the threshold.  Interior pixels have no estimate, they are
+  // close when one of their eight neighbours escaped.
+  bool near_boundary_(const uint32_t* iterations, const float* distance, size_t index, size_t stride, float threshold) const
+  {
+    if (iterations[index] < m_max_iterations)
+    {
+      return distance[index] < threshold;
+    }
+
+    for (auto row : {index - stride, index, index + stride})
+    {
+      if (iterations[row - 1] < m_max_iterations || iterations[row] < m_max_iterations || iterations[row + 1] < m_max_iterations)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Evaluates the pixels of a row listed in columns on a samples x samples grid each, all of them streamed through
+  // the lanes together, and writes their average color.
+  void supersample_(const double* real,
+                    double imaginary,
+                    const std::vector<size_t>& columns,
+                    uint32_t* argb,
+                    const std::atomic<bool>& cancel_token) const
+  {
+    if (columns.empty())
+    {
+      return;
+    }
+
+    const auto samples = m_samples;
+    const auto width = columns.size() * samples;
+    auto sample_real = std::vector<double>(width);
+    auto sample_imaginary = std::vector<double>(samples);
+    for (size_t s = 0; s < samples; ++s)
+    {
+      auto offset = ((static_cast<double>(s) + 0.5) / static_cast<double>(samples) - 0.5) * m_pixel_spacing;
+      sample_imaginary[s] = imaginary + offset;
+      for (size_t n = 0; n < columns.size(); ++n)
+      {
+        sample_real[s + n * samples] = real[columns[n]] + offset;
+      }
+    }
+
+    auto iterations = std::vector<uint32_t>(width * samples);
+    auto kernel = Escape_time_kernel{};
+    if (interior_test_enabled_())
+    {
+      for (size_t t = 0; t < samples; ++t)
+      {
+        classify_(sample_real.data(), sample_imaginary[t], width, iterations.data() + t * width, nullptr);
+      }
+      kernel.set_skip_resolved(true);
+    }
+
+    kernel.invoke_streaming(sample_real.data(),
+                            width,
+                            sample_imaginary.data(),
+                            samples,
+                            k_(),
+                            m_max_iterations,
+                            iterations.data(),
+                            width,
+                            cancel_token,
+                            m_lane_statistics.get());
+
+    const auto count = samples * samples;
+    for (size_t n = 0; n < columns.size(); ++n)
+    {
+      uint32_t sums[4] = {};
+      for (size_t t = 0; t < samples; ++t)
+      {
+        for (size_t s = 0; s < samples; ++s)
+        {
+          auto color = (*m_color_table)(iterations[s + n * samples + t * width]);
+          for (size_t channel = 0; channel < 4; ++channel)
+          {
+            sums[channel] += (color >> (channel * 8)) & 0xff;
+          }
+        }
+      }
+
+      auto color = uint32_t{0};
+      for (size_t channel = 0; channel < 4; ++channel)
+      {
+        color |= ((sums[channel] + count / 2) / count) << (channel * 8);
+      }
+      argb[columns[n]] = color;
+    }
+  }
+
+private:
+  bool m_julia{false};
+  std::complex<double> m_k;
+  size_t m_max_iterations{64};
+  size_t m_samples{4};
+  double m_pixel_spacing{0.0};
+  double m_distance_threshold{1.0};
+  std::shared_ptr<const Color_table> m_color_table{std::make_shared<const Color_table>(Colormap{}, m_max_iterations)};
+  std::shared_ptr<Supersampling_statistics> m_supersampling_statistics;
+  std::shared_ptr<Lane_statistics> m_lane_statistics;
+  Interior_test m_interior_test;
+};
+
+}
+
+#endif /* distance_estimation_function_h */
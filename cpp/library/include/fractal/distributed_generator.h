@@ -9,68 +9,204 @@
 #ifndef distributed_generator_h
 #define distributed_generator_h
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <functional>
-#include <mutex>
-#include <queue>
-#include <thread>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "cost_map.h"
 #include "fractal_view.h"
 #include "messages.h"
+#include "render_handle.h"
 #include "task_parameters.h"
+#include "tile_range.h"
+#include "work_stealing_pool.h"
 
 namespace Fractal
 {
 
+// Detects functions that can evaluate a whole row of pixels at once (see Mandlebrot_function::invoke_row).
+template <typename Function, typename = void>
+struct Has_row_invoke : std::false_type
+{
+};
+
+template <typename Function>
+struct Has_row_invoke<Function, decltype(void(std::declval<const Function&>().invoke_row(std::declval<const double*>(),
+                                                                                          double{},
+                                                                                          size_t{},
+                                                                                          std::declval<uint32_t*>(),
+                                                                                          std::declval<const std::shared_ptr<std::atomic<bool>>&>())))>
+: std::true_type
+{
+};
+
+// Coordinate type of the tables handed to invoke_tile, functions iterating with more precision than a double declare
+// it as Coordinate (see Extended_mandlebrot_function).
+template <typename Function, typename = void>
+struct Tile_coordinate
+{
+  using type = double;
+};
+
+template <typename Function>
+struct Tile_coordinate<Function, decltype(void(sizeof(typename Function::Coordinate)))>
+{
+  using type = typename Function::Coordinate;
+};
+
+// Detects functions that can evaluate a whole tile at once from its coordinate tables (see Mandlebrot_function::invoke_tile).
+template <typename Function, typename = void>
+struct Has_tile_invoke : std::false_type
+{
+};
+
+template <typename Function>
+struct Has_tile_invoke<Function, decltype(void(std::declval<const Function&>().invoke_tile(std::declval<const typename Tile_coordinate<Function>::type*>(),
+                                                                                            size_t{},
+                                                                                            std::declval<const typename Tile_coordinate<Function>::type*>(),
+                                                                                            size_t{},
+                                                                                            std::declval<uint32_t*>(),
+                                                                                            size_t{},
+                                                                                            std::declval<const std::shared_ptr<std::atomic<bool>>&>())))>
+: std::true_type
+{
+};
+
+// Detects functions that can write the escape counts of a tile apart from its colors (see
+// Mandlebrot_function::iterate_tile), used when the view keeps an iteration buffer.
+template <typename Function, typename = void>
+struct Has_tile_iterate : std::false_type
+{
+};
+
+template <typename Function>
+struct Has_tile_iterate<Function, decltype(void(std::declval<const Function&>().iterate_tile(std::declval<const typename Tile_coordinate<Function>::type*>(),
+                                                                                              size_t{},
+                                                                                              std::declval<const typename Tile_coordinate<Function>::type*>(),
+                                                                                              size_t{},
+                                                                                              std::declval<uint32_t*>(),
+                                                                                              std::declval<float*>(),
+                                                                                              size_t{},
+                                                                                              std::declval<const std::shared_ptr<std::atomic<bool>>&>())),
+                                                void(std::declval<const Function&>().color_table()))>
+: std::true_type
+{
+};
+
+// Detects functions that can continue the escape counts of a tile from an Iteration_state (see
+// Mandlebrot_function::resume_tile), used when the view keeps one.
+template <typename Function, typename = void>
+struct Has_tile_resume : std::false_type
+{
+};
+
+template <typename Function>
+struct Has_tile_resume<Function, decltype(void(std::declval<const Function&>().resume_tile(std::declval<const double*>(),
+                                                                                            size_t{},
+                                                                                            std::declval<const double*>(),
+                                                                                            size_t{},
+                                                                                            std::declval<double*>(),
+                                                                                            std::declval<double*>(),
+                                                                                            std::declval<uint32_t*>(),
+                                                                                            std::declval<uint32_t*>(),
+                                                                                            std::declval<float*>(),
+                                                                                            size_t{},
+                                                                                            std::declval<const std::shared_ptr<std::atomic<bool>>&>())),
+                                               void(std::declval<const Function&>().color_table()))>
+: std::true_type
+{
+};
+
+// Detects functions that iterate with a precision chosen per tile (see Adaptive_mandlebrot_function).
+template <typename Function, typename = void>
+struct Has_precision : std::false_type
+{
+};
+
+template <typename Function>
+struct Has_precision<Function, decltype(void(std::declval<Function&>().set_precision(std::declval<Precision>())))>
+: std::true_type
+{
+};
+
+// How the generator covers the pixels of a tile.  Only functions that can evaluate a tile (see Has_tile_invoke) are
+// subdivided or traced, the others are always rendered directly.
+enum class Render_mode : uint8_t
+{
+  // Every pixel is evaluated.
+  direct,
+  // Mariani-Silver subdivision: only the border of a rectangle is evaluated, a uniform border is taken to enclose a
+  // uniform interior which is filled, otherwise the rectangle is split in two and each half goes the same way.
+  subdivide,
+  // Boundary tracing: starting from the border of the tile, the outlines between pixels of different escape counts
+  // are followed and only the pixels along them are evaluated, the regions they enclose are then filled.  A region
+  // that no outline from the border reaches is filled over.
+  trace
+};
+
+// How the tiles of a vector are shared out between the workers.  Tile ranges are always handed out in runs.
+enum class Tile_assignment : uint8_t
+{
+  // Each tile is a task of its own, the workers take them from the pool one at a time in the order of their
+  // priorities, so tiles next to each other go to different workers.
+  shared,
+  // The tiles are handed out in runs of the vector a worker renders in order, the run split in two whenever a worker
+  // goes idle.  With the tiles along a space filling curve (see Tile_order) the tiles of a worker stay next to each
+  // other in the view and in its memory.
+  contiguous
+};
+
 class Distributed_generator final
 {
 public:
-  Distributed_generator() = delete;
+  // Runs on the pool shared by the process (see Work_stealing_pool::shared), constructing a generator starts no
+  // thread.
+  Distributed_generator()
+  : m_pool{Work_stealing_pool::shared()}
+  {
+  }
+  // Runs on a pool of its own.
   Distributed_generator(std::size_t max_thread_count)
-  : m_max_thread_count{max_thread_count}
+  : m_pool{std::make_shared<Work_stealing_pool>(max_thread_count)}
+  {
+  }
+  Distributed_generator(std::shared_ptr<Work_stealing_pool> pool)
+  : m_pool{std::move(pool)}
   {
-    construct_thread_pool_();
   }
   Distributed_generator(const Distributed_generator&) = delete;
   Distributed_generator(Distributed_generator&&) = delete;
+  // The pool may outlive the generator, the tasks still queued use it so they are waited for.
   ~Distributed_generator()
   {
-    destruct_thread_pool_();
+    m_tasks.wait();
   }
   
   Distributed_generator& operator=(const Distributed_generator&) = delete;
   Distributed_generator& operator=(Distributed_generator&&) = delete;
   
+  // Returns once the tasks of this call are done, tasks other callers invoked at the same time don't hold it up.
   template <typename Function>
   void invoke(Function function, Generator_task_parameters& task_parameters)
   {
-    {
-      std::lock_guard<std::mutex> lock{m_tasks_mutex};
-      invoke_(std::move(function), task_parameters);
-      m_task_ready_condition.notify_all();
-    }
-    
-    auto lock = std::unique_lock<std::mutex>{m_tasks_mutex};
-    while (!m_task_done_condition.wait_for(lock, std::chrono::milliseconds(1000), [&] () { return (m_tasks.empty() && m_executing_task_count == 0) || m_destructing; })){}
+    wait_(submit(std::move(function), task_parameters));
   }
   
   template <typename Function>
   void invoke(Function function, std::vector<Generator_task_parameters>& task_parameters)
   {
-    {
-      std::lock_guard<std::mutex> lock{m_tasks_mutex};
-      for (auto& parameter : task_parameters)
-      {
-        invoke_(function, parameter);
-      }
-      
-      m_task_ready_condition.notify_all();
-    }
-    
-    auto lock = std::unique_lock<std::mutex>{m_tasks_mutex};
-    while (!m_task_done_condition.wait_for(lock, std::chrono::milliseconds(1000), [&] () { return (m_tasks.empty() && m_executing_task_count == 0) || m_destructing; })){}
+    wait_(submit(std::move(function), task_parameters));
+  }
+  
+  template <typename Function>
+  void invoke(Function function, Tile_range tiles)
+  {
+    wait_(submit(std::move(function), std::move(tiles)));
   }
   
   template <typename Function>
@@ -85,107 +221,1172 @@ public:
     invoke(std::move(function), task_parameters);
   }
   
+  template <typename Function>
+  void operator()(Function function, Tile_range tiles)
+  {
+    invoke(std::move(function), std::move(tiles));
+  }
+
+  // Starts rendering the tiles and returns right away.  The callbacks of the tiles, and the continuations added to
+  // the handle, run on the executor when one is given and on the worker that finished the tile otherwise.
+  template <typename Function>
+  Render_handle submit(Function function, Generator_task_parameters task_parameters, Executor executor = {})
+  {
+    return submit(std::move(function), std::vector<Generator_task_parameters>{std::move(task_parameters)}, std::move(executor));
+  }
+
+  template <typename Function>
+  Render_handle submit(Function function, std::vector<Generator_task_parameters> task_parameters, Executor executor = {})
+  {
+    auto job = std::make_shared<Render_job>(std::move(executor));
+    job->set_cost_map(m_cost_map);
+    for (auto& parameter : task_parameters)
+    {
+      fit_iteration_buffer_(function, parameter, Has_tile_counts_<Function>{});
+      job->add_tile(parameter);
+    }
+
+    // Held until every tile is queued, a tile finishing early can't complete the job.
+    job->tasks().add();
+    if (m_tile_assignment == Tile_assignment::contiguous && task_parameters.size() > 1)
+    {
+      auto size = task_parameters.size();
+      auto run = std::make_shared<Run_<Function>>(job, std::move(function), std::move(task_parameters), m_render_mode);
+      push_run_(run, 0, size);
+    }
+    else
+    {
+      for (auto& parameter : task_parameters)
+      {
+        invoke_(job, function, parameter);
+      }
+    }
+    job->done();
+
+    return Render_handle{std::move(job)};
+  }
+
+  // The tiles of the range are made as they are rendered, the callbacks get a Generator_task_parameters the worker
+  // refills for each tile, so they copy what they keep of it.
+  template <typename Function>
+  Render_handle submit(Function function, Tile_range tiles, Executor executor = {})
+  {
+    auto job = std::make_shared<Render_job>(std::move(executor));
+    job->set_cost_map(m_cost_map);
+    fit_iteration_buffer_(function, tiles.prototype(), Has_tile_counts_<Function>{});
+    job->add_tiles(tiles.prototype(), tiles.tile_count());
+
+    auto size = tiles.size();
+    auto range = std::make_shared<Range_<Function>>(job, std::move(function), std::move(tiles), m_render_mode);
+    job->tasks().add();
+    if (size != 0)
+    {
+      push_range_(range, 0, size);
+    }
+    job->done();
+
+    return Render_handle{std::move(job)};
+  }
+
+  Render_mode render_mode() const
+  {
+    return m_render_mode;
+  }
+
+  // Applies to the tasks invoked from then on.
+  void set_render_mode(Render_mode render_mode)
+  {
+    m_render_mode = render_mode;
+  }
+
+  Tile_assignment tile_assignment() const
+  {
+    return m_tile_assignment;
+  }
+
+  // Applies to the vectors of tiles invoked from then on.
+  void set_tile_assignment(Tile_assignment tile_assignment)
+  {
+    m_tile_assignment = tile_assignment;
+  }
+
+  const std::shared_ptr<Cost_map>& cost_map() const
+  {
+    return m_cost_map;
+  }
+
+  // The time each task takes is recorded in the map against the pixels it covered, for the next frame to be
+  // distributed by (see Generator_task_parameters::distribute).  Applies to the tasks invoked from then on, null stops
+  // the recording.
+  void set_cost_map(std::shared_ptr<Cost_map> cost_map)
+  {
+    m_cost_map = std::move(cost_map);
+  }
+
+  // Pixels the function was evaluated for by the last invoke to return, the others were filled by subdivision or
+  // tracing.
+  size_t evaluated_pixel_count() const
+  {
+    return m_evaluated_pixel_count;
+  }
+  
 protected:
+  // Tile rendered a part at a time, shared by the tasks subdivision splits it into.
   template <typename Function>
-  void invoke_(Function function, Generator_task_parameters& task_parameters)
+  struct Tile_
   {
-    m_tasks.emplace([function = std::move(function), tp = task_parameters]() mutable
+    Tile_(std::shared_ptr<Render_job> job_, Function function_, Generator_task_parameters tp_)
+    : job{std::move(job_)},
+      function{std::move(function_)},
+      tp{std::move(tp_)},
+      real(tp.pixel_tile_view.width()),
+      imaginary(tp.pixel_tile_view.height())
     {
-      auto real_factor = tp.fractal_view.complex_view().width() / static_cast<double>(tp.fractal_view.pixel_view().width());
-      auto imaginary_factor = tp.fractal_view.complex_view().height() / static_cast<double>(tp.fractal_view.pixel_view().height());
+    }
 
-      auto c = std::complex<double>{};
-      
-      for (size_t i = tp.pixel_tile_view.left; i < tp.pixel_tile_view.right; ++i)
+    std::shared_ptr<Render_job> job;
+    Function function;
+    Generator_task_parameters tp;
+    std::vector<typename Tile_coordinate<Function>::type> real;
+    std::vector<typename Tile_coordinate<Function>::type> imaginary;
+    std::atomic<size_t> pending_task_count{1};
+  };
+
+  // Tile range submitted, shared by the tasks its cells are rendered by.
+  template <typename Function>
+  struct Range_
+  {
+    Range_(std::shared_ptr<Render_job> job_, Function function_, Tile_range tiles_, Render_mode render_mode_)
+    : job{std::move(job_)},
+      function{std::move(function_)},
+      tiles{std::move(tiles_)},
+      render_mode{render_mode_}
+    {
+    }
+
+    std::shared_ptr<Render_job> job;
+    Function function;
+    Tile_range tiles;
+    Render_mode render_mode;
+  };
+
+  // Vector of tiles submitted with Tile_assignment::contiguous, shared by the tasks its runs are rendered by.
+  template <typename Function>
+  struct Run_
+  {
+    Run_(std::shared_ptr<Render_job> job_, Function function_, std::vector<Generator_task_parameters> tiles_, Render_mode render_mode_)
+    : job{std::move(job_)},
+      function{std::move(function_)},
+      tiles{std::move(tiles_)},
+      render_mode{render_mode_}
+    {
+    }
+
+    std::shared_ptr<Render_job> job;
+    Function function;
+    std::vector<Generator_task_parameters> tiles;
+    Render_mode render_mode;
+  };
+
+  // Rectangles whose interior is at most this many pixels are evaluated rather than split further.
+  static constexpr size_t s_subdivision_minimum_area = 64;
+  // Halves of at least this many pixels are queued for any worker, smaller ones are split by the worker at hand.
+  static constexpr size_t s_subdivision_task_area = 64 * 64;
+  // Tracing follows outlines a block at a time, enough pixels that evaluating one keeps the lanes of a vector busy.
+  static constexpr size_t s_trace_block_width = 4;
+  static constexpr size_t s_trace_block_height = 4;
+
+  // Each tile of a vector is a task of its own.
+  template <typename Function>
+  void invoke_(const std::shared_ptr<Render_job>& job, Function function, Generator_task_parameters& task_parameters)
+  {
+    push_task_(job, task_parameters.priority, [this, job, render_mode = m_render_mode, function = std::move(function), tp = task_parameters]() mutable
+    {
+      render_tile_(job, function, tp, render_mode);
+    });
+  }
+
+  // A range is queued as one task for the whole run of cells, which splits off halves as workers go idle (see
+  // Work_stealing_pool::local_queue_empty).  Only the splits cost a task, the cells of a run go through one copy of
+  // the prototype and of the function.
+  template <typename Function>
+  void push_range_(const std::shared_ptr<Range_<Function>>& range, size_t begin, size_t end)
+  {
+    push_task_(range->job, range->tiles.priority(), [this, range, begin, end]()
+    {
+      render_range_(range, begin, end);
+    });
+  }
+
+  template <typename Function>
+  void render_range_(const std::shared_ptr<Range_<Function>>& range, size_t begin, size_t end)
+  {
+    auto tp = range->tiles.prototype();
+    auto function = range->function;
+    for (auto index = begin; index < end; ++index)
+    {
+      if (end - index > 1 && m_pool->local_queue_empty())
       {
-        c.real(tp.fractal_view.complex_view().left + i * real_factor);
-        
-        for (size_t j = tp.pixel_tile_view.top; j < tp.pixel_tile_view.bottom; ++j)
-        {
-          c.imag(tp.fractal_view.complex_view().top + j * imaginary_factor);
-          tp.fractal_view.buffer().get()[i + j * tp.fractal_view.pixel_view().width()] = function(c, tp.cancel_token);
-          
-          if (tp.cancel_token->load())
-          {
-            break;
-          }
-        }
-        
-        if (tp.cancel_token->load())
-        {
-          break;
-        }
+        auto middle = index + (end - index + 1) / 2;
+        push_range_(range, middle, end);
+        end = middle;
       }
-      
-      if (tp.cancel_token->load())
+
+      range->tiles.for_each_tile(index, [&](const Tile_descriptor& tile)
+      {
+        range->tiles.describe(tile, tp);
+        render_tile_(range->job, function, tp, range->render_mode);
+      });
+    }
+  }
+
+  // Runs of a vector split like those of a range, a run is queued with the priority of its first tile.  Each tile is
+  // only ever rendered by the worker whose run holds it.
+  template <typename Function>
+  void push_run_(const std::shared_ptr<Run_<Function>>& run, size_t begin, size_t end)
+  {
+    push_task_(run->job, run->tiles[begin].priority, [this, run, begin, end]()
+    {
+      render_run_(run, begin, end);
+    });
+  }
+
+  template <typename Function>
+  void render_run_(const std::shared_ptr<Run_<Function>>& run, size_t begin, size_t end)
+  {
+    auto function = run->function;
+    for (auto index = begin; index < end; ++index)
+    {
+      if (end - index > 1 && m_pool->local_queue_empty())
       {
-        tp.on_task_canceled(tp);
+        auto middle = index + (end - index + 1) / 2;
+        push_run_(run, middle, end);
+        end = middle;
       }
-      else
+
+      render_tile_(run->job, function, run->tiles[index], run->render_mode);
+    }
+  }
+
+  void wait_(const Render_handle& handle)
+  {
+    handle.wait();
+    m_evaluated_pixel_count = handle.evaluated_pixel_count();
+  }
+
+  // Renders the tile on the worker at hand, timed against its pixels when the job keeps a cost map.  Subdivision
+  // queues the larger rectangles of the tile as tasks of their own.
+  template <typename Function>
+  void render_tile_(const std::shared_ptr<Render_job>& job, Function& function, Generator_task_parameters& tp, Render_mode render_mode)
+  {
+    time_(job, tp.pixel_tile_view, [&]()
+    {
+      set_precision_(function, tp, Has_precision<Function>{});
+      record_precision_(function, tp, Has_precision<Function>{});
+      switch (render_mode)
       {
-        tp.on_task_completed(tp);
+        case Render_mode::subdivide:
+          subdivide_(job, function, tp, Has_tile_invoke<Function>{});
+          break;
+        case Render_mode::trace:
+          trace_(job, function, tp, Has_tile_invoke<Function>{});
+          break;
+        default:
+          execute_tile_(job, function, tp);
+          break;
       }
     });
   }
-  
-private:
-  void construct_thread_pool_()
+
+  template <typename Function>
+  static void execute_tile_(const std::shared_ptr<Render_job>& job, Function& function, Generator_task_parameters& tp)
+  {
+    execute_(function, tp, Has_tile_invoke<Function>{}, Has_row_invoke<Function>{});
+    job->add_evaluated_pixels(tp.pixel_tile_view.width() * tp.pixel_tile_view.height());
+    complete_(tp);
+  }
+
+  static void complete_(const Generator_task_parameters& tp)
+  {
+    if (tp.cancel_token->load())
+    {
+      tp.on_task_canceled(tp);
+    }
+    else
+    {
+      mirror_(tp);
+      tp.on_task_completed(tp);
+    }
+  }
+
+  // Copies the pixels of the tile that have an image across the symmetry of the function (see
+  // Generator_task_parameters::distribute) there, colors and escape counts alike.
+  static void mirror_(const Generator_task_parameters& tp)
+  {
+    if (tp.symmetry == Symmetry::none)
+    {
+      return;
+    }
+
+    const auto& iteration_buffer = tp.fractal_view.iteration_buffer();
+    auto linear = iteration_layout_(tp);
+    mirror_(tp.fractal_view.buffer().get(), tp.fractal_view.layout(), tp);
+
+    switch (iteration_buffer.count())
+    {
+      case Iteration_count::uint16:
+        mirror_(iteration_buffer.counts<uint16_t>(), linear, tp);
+        break;
+      case Iteration_count::uint32:
+        mirror_(iteration_buffer.counts<uint32_t>(), linear, tp);
+        break;
+      default:
+        break;
+    }
+
+    if (iteration_buffer.smooth())
+    {
+      mirror_(iteration_buffer.smooth(), linear, tp);
+    }
+  }
+
+  // The iteration buffer and state are laid out linearly whatever the layout of the colors.
+  static Pixel_layout iteration_layout_(const Generator_task_parameters& tp)
+  {
+    return Pixel_layout{tp.fractal_view.pixel_view().width(), tp.fractal_view.pixel_view().height()};
+  }
+
+  template <typename T>
+  static void mirror_(T* buffer, const Pixel_layout& layout, const Generator_task_parameters& tp)
   {
-    m_thread_pool.reserve(m_max_thread_count);
-    for (size_t i = 0; i < m_max_thread_count; ++i)
+    const auto& source = tp.mirror_source_view;
+    const auto& target = tp.mirror_target_view;
+    for (size_t y = source.top; y < source.bottom; ++y)
     {
-      m_thread_pool.emplace_back([&]()
+      auto target_y = target.bottom - 1 - (y - source.top);
+      if (layout.blocked())
       {
-        while (!m_destructing)
+        // A row of the source and its image can be cut by blocks in different places, a pixel at a time.
+        for (size_t x = 0; x < source.width(); ++x)
         {
-          auto lock = std::unique_lock<std::mutex>{m_tasks_mutex};
-          while (!m_task_ready_condition.wait_for(lock, std::chrono::milliseconds(1000), [&] () { return !m_tasks.empty() || m_destructing; })){}
-        
-          if (m_destructing)
-          {
-            return;
-          }
-        
-          auto task = m_tasks.front();
-          m_tasks.pop();
-          lock.unlock();
-        
-          ++m_executing_task_count;
-          try
-          {
-            task();
-          }
-          catch (...)
-          {
-          }
-          --m_executing_task_count;
-          m_task_done_condition.notify_one();
+          auto target_x = tp.symmetry == Symmetry::origin ? target.right - 1 - x : target.left + x;
+          buffer[layout.offset(target_x, target_y)] = buffer[layout.offset(source.left + x, y)];
         }
-      });
+        continue;
+      }
+
+      const auto* from = buffer + layout.offset(source.left, y);
+      auto* to = buffer + layout.offset(target.left, target_y);
+      if (tp.symmetry == Symmetry::origin)
+      {
+        std::reverse_copy(from, from + source.width(), to);
+      }
+      else
+      {
+        std::copy(from, from + source.width(), to);
+      }
     }
   }
-  
-  void destruct_thread_pool_()
+
+  template <typename Function>
+  void subdivide_(const std::shared_ptr<Render_job>& job, Function& function, Generator_task_parameters& tp, std::false_type)
+  {
+    execute_tile_(job, function, tp);
+  }
+
+  // The border of the tile is evaluated first, the rectangles it is then split into are queued as tasks of their own
+  // for idle workers to pick up.  The tile is complete once the last of them is done.
+  template <typename Function>
+  void subdivide_(const std::shared_ptr<Render_job>& job, Function& function, Generator_task_parameters& tp, std::true_type)
+  {
+    auto subdivision = std::make_shared<Tile_<Function>>(job, function, tp);
+    coordinates_(subdivision->tp, subdivision->real, subdivision->imaginary);
+
+    evaluate_border_(*subdivision);
+    subdivide_task_(subdivision, subdivision->tp.pixel_tile_view);
+  }
+
+  template <typename Function>
+  void evaluate_border_(const Tile_<Function>& tile)
+  {
+    const auto& view = tile.tp.pixel_tile_view;
+    evaluate_(tile, Fractal_view::Pixel_view{view.left, view.top, view.right, view.top + 1});
+    if (view.height() > 1)
+    {
+      evaluate_(tile, Fractal_view::Pixel_view{view.left, view.bottom - 1, view.right, view.bottom});
+    }
+    if (view.height() > 2)
+    {
+      evaluate_(tile, Fractal_view::Pixel_view{view.left, view.top + 1, view.left + 1, view.bottom - 1});
+      if (view.width() > 1)
+      {
+        evaluate_(tile, Fractal_view::Pixel_view{view.right - 1, view.top + 1, view.right, view.bottom - 1});
+      }
+    }
+  }
+
+  template <typename Function>
+  void subdivide_task_(const std::shared_ptr<Tile_<Function>>& subdivision, Fractal_view::Pixel_view rectangle)
   {
-    m_destructing = true;
-    m_task_ready_condition.notify_all();
-    for (auto& thread : m_thread_pool)
+    split_(subdivision, rectangle);
+
+    if (--subdivision->pending_task_count == 0)
     {
-      thread.join();
+      complete_(subdivision->tp);
     }
   }
 
-private:
-  using Task_predicate = std::function<void()>;
-  std::queue<Task_predicate> m_tasks;
-  std::mutex m_tasks_mutex;
-  std::atomic<size_t> m_executing_task_count{0};
-  std::condition_variable m_task_ready_condition;
-  std::condition_variable m_task_done_condition;
-  
-  std::vector<std::thread> m_thread_pool;
-  std::size_t m_max_thread_count{7};
-  std::atomic<bool> m_destructing{false};
+  // Fills or splits a rectangle whose border has been evaluated.  A split evaluates the line between the two halves,
+  // which becomes part of the border of both.
+  template <typename Function>
+  void split_(const std::shared_ptr<Tile_<Function>>& subdivision, Fractal_view::Pixel_view rectangle)
+  {
+    const auto& tp = subdivision->tp;
+    while (!tp.cancel_token->load() && rectangle.width() > 2 && rectangle.height() > 2)
+    {
+      auto interior = Fractal_view::Pixel_view{rectangle.left + 1, rectangle.top + 1, rectangle.right - 1, rectangle.bottom - 1};
+      if (uniform_border_(tp, rectangle))
+      {
+        fill_(tp, interior, rectangle.left, rectangle.top);
+        return;
+      }
+
+      if (interior.width() * interior.height() <= s_subdivision_minimum_area)
+      {
+        evaluate_(*subdivision, interior);
+        return;
+      }
+
+      auto first = rectangle;
+      auto second = rectangle;
+      if (rectangle.width() >= rectangle.height())
+      {
+        auto middle = rectangle.left + rectangle.width() / 2;
+        evaluate_(*subdivision, Fractal_view::Pixel_view{middle, interior.top, middle + 1, interior.bottom});
+        first.right = middle + 1;
+        second.left = middle;
+      }
+      else
+      {
+        auto middle = rectangle.top + rectangle.height() / 2;
+        evaluate_(*subdivision, Fractal_view::Pixel_view{interior.left, middle, interior.right, middle + 1});
+        first.bottom = middle + 1;
+        second.top = middle;
+      }
+
+      // Large halves are left to whichever worker is free, this one carries on with the second half.
+      if (first.width() * first.height() >= s_subdivision_task_area)
+      {
+        ++subdivision->pending_task_count;
+        push_task_(subdivision->job, 0, [this, subdivision, first]()
+        {
+          time_(subdivision->job, first, [&]()
+          {
+            subdivide_task_(subdivision, first);
+          });
+        });
+      }
+      else
+      {
+        split_(subdivision, first);
+      }
+
+      rectangle = second;
+    }
+  }
+
+  template <typename Function>
+  void evaluate_(const Tile_<Function>& tile, const Fractal_view::Pixel_view& rectangle)
+  {
+    evaluate_(tile.function, tile.tp, tile.real.data(), tile.imaginary.data(), rectangle);
+    tile.job->add_evaluated_pixels(rectangle.width() * rectangle.height());
+  }
+
+  // The colors, and escape counts when the view keeps them, must all be the same.
+  static bool uniform_border_(const Generator_task_parameters& tp, const Fractal_view::Pixel_view& rectangle)
+  {
+    const auto& iteration_buffer = tp.fractal_view.iteration_buffer();
+    auto linear = iteration_layout_(tp);
+    if (!uniform_border_(tp.fractal_view.buffer().get(), tp.fractal_view.layout(), rectangle))
+    {
+      return false;
+    }
+
+    switch (iteration_buffer.count())
+    {
+      case Iteration_count::uint16:
+        if (!uniform_border_(iteration_buffer.counts<uint16_t>(), linear, rectangle))
+        {
+          return false;
+        }
+        break;
+      case Iteration_count::uint32:
+        if (!uniform_border_(iteration_buffer.counts<uint32_t>(), linear, rectangle))
+        {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+
+    return !iteration_buffer.smooth() || uniform_border_(iteration_buffer.smooth(), linear, rectangle);
+  }
+
+  template <typename T>
+  static bool uniform_border_(const T* buffer, const Pixel_layout& layout, const Fractal_view::Pixel_view& rectangle)
+  {
+    const auto value = buffer[layout.offset(rectangle.left, rectangle.top)];
+    for (size_t x = rectangle.left; x < rectangle.right; ++x)
+    {
+      if (buffer[layout.offset(x, rectangle.top)] != value || buffer[layout.offset(x, rectangle.bottom - 1)] != value)
+      {
+        return false;
+      }
+    }
+
+    for (size_t y = rectangle.top + 1; y < rectangle.bottom - 1; ++y)
+    {
+      if (buffer[layout.offset(rectangle.left, y)] != value || buffer[layout.offset(rectangle.right - 1, y)] != value)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Copies the pixel at (x, y), in the colors and in the iteration buffer, over the rectangle.
+  static void fill_(const Generator_task_parameters& tp, const Fractal_view::Pixel_view& rectangle, size_t x, size_t y)
+  {
+    const auto& iteration_buffer = tp.fractal_view.iteration_buffer();
+    auto linear = iteration_layout_(tp);
+    fill_(tp.fractal_view.buffer().get(), tp.fractal_view.layout(), rectangle, x, y);
+
+    switch (iteration_buffer.count())
+    {
+      case Iteration_count::uint16:
+        fill_(iteration_buffer.counts<uint16_t>(), linear, rectangle, x, y);
+        break;
+      case Iteration_count::uint32:
+        fill_(iteration_buffer.counts<uint32_t>(), linear, rectangle, x, y);
+        break;
+      default:
+        break;
+    }
+
+    if (iteration_buffer.smooth())
+    {
+      fill_(iteration_buffer.smooth(), linear, rectangle, x, y);
+    }
+  }
+
+  template <typename T>
+  static void fill_(T* buffer, const Pixel_layout& layout, const Fractal_view::Pixel_view& rectangle, size_t x, size_t y)
+  {
+    const auto value = buffer[layout.offset(x, y)];
+    for (size_t row = rectangle.top; row < rectangle.bottom; ++row)
+    {
+      for (size_t column = rectangle.left; column < rectangle.right;)
+      {
+        auto count = std::min(layout.run(column), rectangle.right - column);
+        auto* run = buffer + layout.offset(column, row);
+        std::fill(run, run + count, value);
+        column += count;
+      }
+    }
+  }
+  
+  template <typename Function>
+  void trace_(const std::shared_ptr<Render_job>& job, Function& function, Generator_task_parameters& tp, std::false_type)
+  {
+    execute_tile_(job, function, tp);
+  }
+
+  // Each tile is traced on its own.  Its border is always evaluated in full, so the outlines meet exactly at the seams
+  // between tiles.  Inside a tile, a region no outline leads to is missed (see trace_tile_).
+  template <typename Function>
+  void trace_(const std::shared_ptr<Render_job>& job, Function& function, Generator_task_parameters& tp, std::true_type)
+  {
+    Tile_<Function> tile{job, function, tp};
+    coordinates_(tile.tp, tile.real, tile.imaginary);
+    trace_tile_(tile);
+    complete_(tile.tp);
+  }
+
+  // Works on blocks of s_trace_block_width x s_trace_block_height pixels, a wave at a time: the neighbors of every
+  // block of the last wave holding pixels that differ, from each other or from the evaluated blocks around, are
+  // evaluated next, so the outline between two regions is followed wherever it goes.  Blocks that were never reached
+  // have no outline going through them and take the value of the pixel to their left, without being checked.  A region
+  // touching neither the border of the tile nor the outline of another region is therefore filled over, as it is by
+  // subdivision when a uniform border encloses it.  The escape bands of the Mandlebrot set are nested around the set
+  // and rarely leave such regions, islands of a disconnected Julia set or of the Burning ship can be lost.
+  // Render_mode::direct evaluates every pixel.
+  template <typename Function>
+  void trace_tile_(const Tile_<Function>& tile)
+  {
+    const auto& tp = tile.tp;
+    const auto& view = tp.pixel_tile_view;
+    const auto columns = (view.width() + s_trace_block_width - 1) / s_trace_block_width;
+    const auto rows = (view.height() + s_trace_block_height - 1) / s_trace_block_height;
+    if (columns == 0 || rows == 0)
+    {
+      return;
+    }
+
+    enum : uint8_t { unreached, queued, evaluated };
+    auto state = std::vector<uint8_t>(columns * rows, unreached);
+    auto wave = std::vector<size_t>{};
+    auto next = std::vector<size_t>{};
+
+    // Pixels of a block, those of the last column and row may be cut short by the tile.
+    auto pixels = [&](size_t block)
+    {
+      auto left = view.left + (block % columns) * s_trace_block_width;
+      auto top = view.top + (block / columns) * s_trace_block_height;
+      return Fractal_view::Pixel_view{left,
+                                      top,
+                                      std::min(left + s_trace_block_width, view.right),
+                                      std::min(top + s_trace_block_height, view.bottom)};
+    };
+
+    auto block_of = [&](size_t x, size_t y)
+    {
+      return (x - view.left) / s_trace_block_width + ((y - view.top) / s_trace_block_height) * columns;
+    };
+
+    auto reach = [&](size_t block)
+    {
+      auto column = block % columns;
+      auto row = block / columns;
+      for (size_t j = row > 0 ? row - 1 : 0; j <= std::min(row + 1, rows - 1); ++j)
+      {
+        for (size_t i = column > 0 ? column - 1 : 0; i <= std::min(column + 1, columns - 1); ++i)
+        {
+          if (state[i + j * columns] == unreached)
+          {
+            state[i + j * columns] = queued;
+            next.push_back(i + j * columns);
+          }
+        }
+      }
+    };
+
+    // The blocks along the border of the tile are the first wave.
+    for (size_t row = 0; row < rows; ++row)
+    {
+      for (size_t column = 0; column < columns; column += (row == 0 || row == rows - 1 || columns < 2) ? 1 : columns - 1)
+      {
+        state[column + row * columns] = queued;
+        next.push_back(column + row * columns);
+      }
+    }
+
+    while (!next.empty() && !tp.cancel_token->load())
+    {
+      // Runs of blocks along a row are evaluated together.
+      std::sort(next.begin(), next.end());
+      wave.clear();
+      for (size_t n = 0; n < next.size();)
+      {
+        auto end = n + 1;
+        while (end < next.size() && next[end] == next[end - 1] + 1 && next[end] % columns != 0)
+        {
+          ++end;
+        }
+
+        auto first = pixels(next[n]);
+        auto last = pixels(next[end - 1]);
+        evaluate_(tile, Fractal_view::Pixel_view{first.left, first.top, last.right, last.bottom});
+        for (; n < end; ++n)
+        {
+          state[next[n]] = evaluated;
+          wave.push_back(next[n]);
+        }
+      }
+      next.clear();
+
+      // Each pixel is compared with its right and lower neighbors, and with its left and upper neighbors when they
+      // belong to another block, whenever that neighbor has been evaluated.
+      for (auto block : wave)
+      {
+        auto rectangle = pixels(block);
+        auto compare = [&](size_t at_x, size_t at_y, size_t x, size_t y)
+        {
+          auto neighbor = block_of(x, y);
+          if (state[neighbor] == evaluated && !same_pixel_(tp, at_x, at_y, x, y))
+          {
+            reach(block);
+            reach(neighbor);
+          }
+        };
+
+        for (size_t y = rectangle.top; y < rectangle.bottom; ++y)
+        {
+          for (size_t x = rectangle.left; x < rectangle.right; ++x)
+          {
+            if (x + 1 < view.right)
+            {
+              compare(x, y, x + 1, y);
+            }
+            if (y + 1 < view.bottom)
+            {
+              compare(x, y, x, y + 1);
+            }
+            if (x == rectangle.left && x > view.left)
+            {
+              compare(x, y, x - 1, y);
+            }
+            if (y == rectangle.top && y > view.top)
+            {
+              compare(x, y, x, y - 1);
+            }
+          }
+        }
+      }
+    }
+
+    if (tp.cancel_token->load())
+    {
+      return;
+    }
+
+    for (size_t block = 0; block < state.size(); ++block)
+    {
+      if (state[block] != unreached)
+      {
+        continue;
+      }
+
+      auto rectangle = pixels(block);
+      for (auto y = rectangle.top; y < rectangle.bottom; ++y)
+      {
+        fill_(tp, Fractal_view::Pixel_view{rectangle.left, y, rectangle.right, y + 1}, rectangle.left - 1, y);
+      }
+    }
+  }
+
+  // Pixels of the view at (a_x, a_y) and (b_x, b_y) have the same color, and the same escape counts when the view
+  // keeps them.
+  static bool same_pixel_(const Generator_task_parameters& tp, size_t a_x, size_t a_y, size_t b_x, size_t b_y)
+  {
+    if (tp.fractal_view.pixel(a_x, a_y) != tp.fractal_view.pixel(b_x, b_y))
+    {
+      return false;
+    }
+
+    const auto& iteration_buffer = tp.fractal_view.iteration_buffer();
+    auto stride = tp.fractal_view.pixel_view().width();
+    auto a = a_x + a_y * stride;
+    auto b = b_x + b_y * stride;
+
+    switch (iteration_buffer.count())
+    {
+      case Iteration_count::uint16:
+        if (iteration_buffer.counts<uint16_t>()[a] != iteration_buffer.counts<uint16_t>()[b])
+        {
+          return false;
+        }
+        break;
+      case Iteration_count::uint32:
+        if (iteration_buffer.counts<uint32_t>()[a] != iteration_buffer.counts<uint32_t>()[b])
+        {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+
+    return !iteration_buffer.smooth() || iteration_buffer.smooth()[a] == iteration_buffer.smooth()[b];
+  }
+
+  template <typename Function>
+  using Has_tile_counts_ = std::integral_constant<bool, Has_tile_iterate<Function>::value || Has_tile_resume<Function>::value>;
+
+  // uint16 escape counts only hold max_iterations below UINT16_MAX, past that the counts would wrap and run into
+  // Escape_time_kernel::pending.  A function iterating that far renders without them: the tile drops the buffer from
+  // its own copy of the view and is colored directly, the counts keep what an earlier render, which may still be
+  // writing them, left there.
+  template <typename Function>
+  static void fit_iteration_buffer_(const Function& function, Generator_task_parameters& tp, std::true_type)
+  {
+    if (tp.fractal_view.iteration_buffer().count() == Iteration_count::uint16 &&
+        function.color_table()->max_iterations() >= UINT16_MAX)
+    {
+      tp.fractal_view.set_iteration_buffer(Iteration_count::none);
+    }
+  }
+
+  template <typename Function>
+  static void fit_iteration_buffer_(const Function&, Generator_task_parameters&, std::false_type)
+  {
+  }
+
+  template <typename Function>
+  static void set_precision_(Function& function, Generator_task_parameters& tp, std::true_type)
+  {
+    tp.precision = select_precision(tp.resolution_bits, function.max_iterations());
+    function.set_precision(tp.precision);
+  }
+
+  template <typename Function>
+  static void set_precision_(Function&, Generator_task_parameters&, std::false_type)
+  {
+  }
+
+  // Once per tile, however many times subdivision or tracing call the function on parts of it.
+  template <typename Function>
+  static void record_precision_(const Function& function, const Generator_task_parameters& tp, std::true_type)
+  {
+    if (function.precision_statistics())
+    {
+      function.precision_statistics()->record(tp.precision, tp.pixel_tile_view.width() * tp.pixel_tile_view.height());
+    }
+  }
+
+  template <typename Function>
+  static void record_precision_(const Function&, const Generator_task_parameters&, std::false_type)
+  {
+  }
+
+  // Row by row, the pixels of a row evaluated into a scratch row that is copied out whole, rather than down the
+  // columns where each pixel lands a row of the image after the last.
+  template <typename Function>
+  static void execute_(Function& function, Generator_task_parameters& tp, std::false_type, std::false_type)
+  {
+    auto real_factor = tp.fractal_view.complex_view().width() / static_cast<double>(tp.fractal_view.pixel_view().width());
+    auto imaginary_factor = tp.fractal_view.complex_view().height() / static_cast<double>(tp.fractal_view.pixel_view().height());
+
+    auto& real = scratch_<double, 0>(tp.pixel_tile_view.width());
+    for (size_t i = 0; i < real.size(); ++i)
+    {
+      real[i] = tp.fractal_view.complex_view().left + (i + tp.pixel_tile_view.left) * real_factor;
+    }
+
+    auto& row = scratch_<uint32_t, 0>(tp.pixel_tile_view.width());
+    auto c = std::complex<double>{};
+    for (size_t j = tp.pixel_tile_view.top; j < tp.pixel_tile_view.bottom; ++j)
+    {
+      c.imag(tp.fractal_view.complex_view().top + j * imaginary_factor);
+      for (size_t i = 0; i < row.size(); ++i)
+      {
+        c.real(real[i]);
+        row[i] = function(c, tp.cancel_token);
+      }
+      tp.fractal_view.write(Fractal_view::Pixel_view{tp.pixel_tile_view.left, j, tp.pixel_tile_view.right, j + 1}, row.data(), row.size());
+
+      if (tp.cancel_token->load())
+      {
+        break;
+      }
+    }
+  }
+  
+  template <typename Function>
+  static void execute_(Function& function, Generator_task_parameters& tp, std::false_type, std::true_type)
+  {
+    auto real_factor = tp.fractal_view.complex_view().width() / static_cast<double>(tp.fractal_view.pixel_view().width());
+    auto imaginary_factor = tp.fractal_view.complex_view().height() / static_cast<double>(tp.fractal_view.pixel_view().height());
+
+    // Real coordinates are shared by every row of the tile.
+    auto& real = scratch_<double, 0>(tp.pixel_tile_view.width());
+    for (size_t i = 0; i < real.size(); ++i)
+    {
+      real[i] = tp.fractal_view.complex_view().left + (i + tp.pixel_tile_view.left) * real_factor;
+    }
+    
+    for (size_t j = tp.pixel_tile_view.top; j < tp.pixel_tile_view.bottom; ++j)
+    {
+      auto imaginary = tp.fractal_view.complex_view().top + j * imaginary_factor;
+      auto row = Fractal_view::Pixel_view{tp.pixel_tile_view.left, j, tp.pixel_tile_view.right, j + 1};
+      colors_(tp, row, [&](uint32_t* argb, size_t)
+      {
+        function.invoke_row(real.data(), imaginary, real.size(), argb, tp.cancel_token);
+      });
+      
+      if (tp.cancel_token->load())
+      {
+        break;
+      }
+    }
+  }
+  
+  template <typename Function, typename Row_invoke>
+  static void execute_(Function& function, Generator_task_parameters& tp, std::true_type, Row_invoke)
+  {
+    auto& real = scratch_<typename Tile_coordinate<Function>::type, 0>(tp.pixel_tile_view.width());
+    auto& imaginary = scratch_<typename Tile_coordinate<Function>::type, 1>(tp.pixel_tile_view.height());
+    coordinates_(tp, real, imaginary);
+    evaluate_(function, tp, real.data(), imaginary.data(), tp.pixel_tile_view);
+  }
+
+  // Coordinate tables of the worker at hand, kept from one tile to the next so rendering a tile allocates nothing once
+  // the worker has seen a tile as large.
+  template <typename T, int Table>
+  static std::vector<T>& scratch_(size_t size)
+  {
+    thread_local std::vector<T> table;
+    table.resize(size);
+    return table;
+  }
+
+  // Evaluates a rectangle of the tile, real and imaginary being the coordinate tables of the whole tile.
+  template <typename Function, typename Coordinate>
+  static void evaluate_(const Function& function,
+                        const Generator_task_parameters& tp,
+                        const Coordinate* real,
+                        const Coordinate* imaginary,
+                        const Fractal_view::Pixel_view& rectangle)
+  {
+    real += rectangle.left - tp.pixel_tile_view.left;
+    imaginary += rectangle.top - tp.pixel_tile_view.top;
+    if (resume_tile_(function, tp, real, imaginary, rectangle, Has_tile_resume<Function>{}))
+    {
+      return;
+    }
+
+    if (iterate_tile_(function, tp, real, imaginary, rectangle, Has_tile_iterate<Function>{}))
+    {
+      return;
+    }
+
+    const auto& layout = tp.fractal_view.layout();
+    auto stride = tp.fractal_view.pixel_view().width();
+    if (!layout.blocked() && (rectangle.height() == 1 || rectangle.width() == stride))
+    {
+      auto tile = tp.fractal_view.buffer().get() + layout.offset(rectangle.left, rectangle.top);
+      function.invoke_tile(real, rectangle.width(), imaginary, rectangle.height(), tile, stride, tp.cancel_token);
+      return;
+    }
+
+    // Evaluated into a scratch tile as wide as the rectangle, then copied out a row at a time: the function's passes
+    // over the tile stay within one block of memory rather than touching a page of a wide image per row.
+    auto& scratch = scratch_<uint32_t, 1>(rectangle.width() * rectangle.height());
+    function.invoke_tile(real, rectangle.width(), imaginary, rectangle.height(), scratch.data(), rectangle.width(), tp.cancel_token);
+    layout.write(tp.fractal_view.buffer().get(), rectangle, scratch.data(), rectangle.width());
+  }
+
+  // Has invoke write the colors of the rectangle, given where to and the stride of the rows there: straight into the
+  // view when its layout is linear, through a scratch tile copied into the blocks otherwise.
+  template <typename Invoke>
+  static void colors_(const Generator_task_parameters& tp, const Fractal_view::Pixel_view& rectangle, Invoke invoke)
+  {
+    const auto& layout = tp.fractal_view.layout();
+    if (!layout.blocked())
+    {
+      invoke(tp.fractal_view.buffer().get() + layout.offset(rectangle.left, rectangle.top), tp.fractal_view.pixel_view().width());
+      return;
+    }
+
+    auto& scratch = scratch_<uint32_t, 1>(rectangle.width() * rectangle.height());
+    invoke(scratch.data(), rectangle.width());
+    layout.write(tp.fractal_view.buffer().get(), rectangle, scratch.data(), rectangle.width());
+  }
+
+  // Views with an iteration state continue each pixel of the rectangle from where the last render stopped, the
+  // escape counts land in the iteration buffer.  Returns false when the rectangle has to be evaluated from scratch.
+  template <typename Function, typename Coordinate>
+  static bool resume_tile_(const Function& function,
+                           const Generator_task_parameters& tp,
+                           const Coordinate* real,
+                           const Coordinate* imaginary,
+                           const Fractal_view::Pixel_view& rectangle,
+                           std::true_type)
+  {
+    const auto& iteration_state = tp.fractal_view.iteration_state();
+    if (iteration_state.empty())
+    {
+      return false;
+    }
+
+    const auto& iteration_buffer = tp.fractal_view.iteration_buffer();
+    switch (iteration_buffer.count())
+    {
+      case Iteration_count::uint16:
+        resume_tile_(function, tp, real, imaginary, rectangle, iteration_buffer.counts<uint16_t>());
+        return true;
+      case Iteration_count::uint32:
+        resume_tile_(function, tp, real, imaginary, rectangle, iteration_buffer.counts<uint32_t>());
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  template <typename Function, typename Coordinate>
+  static bool resume_tile_(const Function&,
+                           const Generator_task_parameters&,
+                           const Coordinate*,
+                           const Coordinate*,
+                           const Fractal_view::Pixel_view&,
+                           std::false_type)
+  {
+    return false;
+  }
+
+  template <typename Function, typename Count>
+  static void resume_tile_(const Function& function,
+                           const Generator_task_parameters& tp,
+                           const double* real,
+                           const double* imaginary,
+                           const Fractal_view::Pixel_view& rectangle,
+                           Count* counts)
+  {
+    const auto& iteration_state = tp.fractal_view.iteration_state();
+    auto stride = tp.fractal_view.pixel_view().width();
+    auto offset = rectangle.left + rectangle.top * stride;
+    auto smooth = tp.fractal_view.iteration_buffer().smooth() ? tp.fractal_view.iteration_buffer().smooth() + offset : nullptr;
+
+    function.resume_tile(real,
+                         rectangle.width(),
+                         imaginary,
+                         rectangle.height(),
+                         iteration_state.real() + offset,
+                         iteration_state.imaginary() + offset,
+                         iteration_state.iterations() + offset,
+                         counts + offset,
+                         smooth,
+                         stride,
+                         tp.cancel_token);
+    colors_(tp, rectangle, [&](uint32_t* argb, size_t argb_stride)
+    {
+      function.color_table()->invoke_tile(counts + offset, smooth, rectangle.width(), rectangle.height(), stride, argb, argb_stride);
+    });
+  }
+
+  // Views with an iteration buffer get the escape counts of the rectangle there, the colors are then looked up from
+  // them.  Returns false when the rectangle still has to be evaluated straight into colors.
+  template <typename Function, typename Coordinate>
+  static bool iterate_tile_(const Function& function,
+                            const Generator_task_parameters& tp,
+                            const Coordinate* real,
+                            const Coordinate* imaginary,
+                            const Fractal_view::Pixel_view& rectangle,
+                            std::true_type)
+  {
+    const auto& iteration_buffer = tp.fractal_view.iteration_buffer();
+    switch (iteration_buffer.count())
+    {
+      case Iteration_count::uint16:
+        iterate_tile_(function, tp, real, imaginary, rectangle, iteration_buffer.counts<uint16_t>());
+        return true;
+      case Iteration_count::uint32:
+        iterate_tile_(function, tp, real, imaginary, rectangle, iteration_buffer.counts<uint32_t>());
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  template <typename Function, typename Coordinate>
+  static bool iterate_tile_(const Function&,
+                            const Generator_task_parameters&,
+                            const Coordinate*,
+                            const Coordinate*,
+                            const Fractal_view::Pixel_view&,
+                            std::false_type)
+  {
+    return false;
+  }
+
+  template <typename Function, typename Coordinate, typename Count>
+  static void iterate_tile_(const Function& function,
+                            const Generator_task_parameters& tp,
+                            const Coordinate* real,
+                            const Coordinate* imaginary,
+                            const Fractal_view::Pixel_view& rectangle,
+                            Count* counts)
+  {
+    auto stride = tp.fractal_view.pixel_view().width();
+    auto offset = rectangle.left + rectangle.top * stride;
+    auto smooth = tp.fractal_view.iteration_buffer().smooth() ? tp.fractal_view.iteration_buffer().smooth() + offset : nullptr;
+
+    function.iterate_tile(real, rectangle.width(), imaginary, rectangle.height(), counts + offset, smooth, stride, tp.cancel_token);
+    colors_(tp, rectangle, [&](uint32_t* argb, size_t argb_stride)
+    {
+      function.color_table()->invoke_tile(counts + offset, smooth, rectangle.width(), rectangle.height(), stride, argb, argb_stride);
+    });
+  }
+  
+  static void coordinates_(const Generator_task_parameters& tp, std::vector<double>& real, std::vector<double>& imaginary)
+  {
+    auto real_factor = tp.fractal_view.complex_view().width() / static_cast<double>(tp.fractal_view.pixel_view().width());
+    auto imaginary_factor = tp.fractal_view.complex_view().height() / static_cast<double>(tp.fractal_view.pixel_view().height());
+
+    for (size_t i = 0; i < real.size(); ++i)
+    {
+      real[i] = tp.fractal_view.complex_view().left + (i + tp.pixel_tile_view.left) * real_factor;
+    }
+
+    for (size_t j = 0; j < imaginary.size(); ++j)
+    {
+      imaginary[j] = tp.fractal_view.complex_view().top + (j + tp.pixel_tile_view.top) * imaginary_factor;
+    }
+  }
+
+  // Extended coordinates are computed from the exact view in quad-double and narrowed to the function's type.
+  template <typename Number>
+  static void coordinates_(const Generator_task_parameters& tp, std::vector<Number>& real, std::vector<Number>& imaginary)
+  {
+    auto view = tp.fractal_view.extended_complex_view();
+    auto real_factor = view.width() / Quad_double{static_cast<double>(tp.fractal_view.pixel_view().width())};
+    auto imaginary_factor = view.height() / Quad_double{static_cast<double>(tp.fractal_view.pixel_view().height())};
+
+    for (size_t i = 0; i < real.size(); ++i)
+    {
+      auto offset = Quad_double{static_cast<double>(i + tp.pixel_tile_view.left)} * real_factor;
+      real[i] = Extended_precision_traits<Number>::from(view.left + offset);
+    }
+
+    for (size_t j = 0; j < imaginary.size(); ++j)
+    {
+      auto offset = Quad_double{static_cast<double>(j + tp.pixel_tile_view.top)} * imaginary_factor;
+      imaginary[j] = Extended_precision_traits<Number>::from(view.top + offset);
+    }
+  }
+  
+private:
+  // Tasks pushed from a worker, like the rectangles of a subdivided tile, go to that worker's own deque.  The job
+  // counts the task from the moment it is pushed, a task spawning another is still running then, so the count of a
+  // job can't drop to zero before all its tasks are done.  The priority of a tile orders it against the tiles of every
+  // render queued (see Generator_task_parameters::order).
+  template <typename Task>
+  void push_task_(const std::shared_ptr<Render_job>& job, int priority, Task task)
+  {
+    job->tasks().add();
+    m_tasks.add();
+    m_pool->push([this, job, task = std::move(task)]() mutable
+    {
+      task();
+      job->done();
+      m_tasks.done();
+    }, priority);
+  }
+
+  // Records how long task took against the pixels of rectangle when the job keeps a cost map.
+  template <typename Task>
+  static void time_(const std::shared_ptr<Render_job>& job, const Fractal_view::Pixel_view& rectangle, Task task)
+  {
+    if (!job->cost_map())
+    {
+      task();
+      return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    task();
+    job->cost_map()->record(rectangle, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+
+private:
+  Render_mode m_render_mode{Render_mode::direct};
+  Tile_assignment m_tile_assignment{Tile_assignment::shared};
+  std::atomic<size_t> m_evaluated_pixel_count{0};
+  std::shared_ptr<Cost_map> m_cost_map;
+  // Every task queued and not yet done, whatever its job.
+  Task_group m_tasks;
+  std::shared_ptr<Work_stealing_pool> m_pool;
 };
 
 }
@@ -0,0 +1,1570 @@
+//
+//  escape_time_kernel.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef escape_time_kernel_h
+#define escape_time_kernel_h
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "iteration_state.h"
+
+namespace Fractal
+{
+
+enum class Instruction_set : uint8_t
+{
+  portable,
+  sse2,
+  avx2,
+  avx512
+};
+
+inline const char* to_string(Instruction_set instruction_set)
+{
+  switch (instruction_set)
+  {
+    case Instruction_set::sse2: return "sse2";
+    case Instruction_set::avx2: return "avx2";
+    case Instruction_set::avx512: return "avx512";
+    default: return "portable";
+  }
+}
+
+// Counts how busy the SIMD lanes were.  Every iteration of a lane group adds the group width to lane_iterations and
+// the number of lanes still working on a pixel to active_lane_iterations.
+struct Lane_statistics
+{
+  std::atomic<uint64_t> active_lane_iterations{0};
+  std::atomic<uint64_t> lane_iterations{0};
+
+  double utilization() const
+  {
+    auto total = lane_iterations.load();
+    if (total == 0)
+    {
+      return 1.0;
+    }
+    return static_cast<double>(active_lane_iterations.load()) / static_cast<double>(total);
+  }
+
+  void reset()
+  {
+    active_lane_iterations = 0;
+    lane_iterations = 0;
+  }
+};
+
+// Keep the lanes bit-identical with the scalar invoke of the functions, targets with FMA would otherwise contract
+// the escape test and the iteration.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Iterates z = z * z + c for a row of pixels a lane group at a time and writes the escape iteration of each
+// pixel (or max_iterations when it never escapes).  The widest instruction set the CPU reports through CPUID
+// is picked at runtime, lanes that escape are masked off and the group finishes when every lane has escaped.
+class Escape_time_kernel final
+{
+public:
+  // Marks an iteration entry that still has to be computed (see invoke_streaming), truncated to UINT16_MAX in
+  // uint16_t counts.
+  static constexpr uint32_t pending = UINT32_MAX;
+
+  Escape_time_kernel()
+  : m_instruction_set{supported_instruction_set()}
+  {
+  }
+  Escape_time_kernel(Instruction_set instruction_set)
+  : m_instruction_set{std::min(instruction_set, supported_instruction_set())}
+  {
+  }
+  Escape_time_kernel(const Escape_time_kernel&) = default;
+  Escape_time_kernel(Escape_time_kernel&&) = default;
+  ~Escape_time_kernel() = default;
+
+  Escape_time_kernel& operator=(const Escape_time_kernel&) = default;
+  Escape_time_kernel& operator=(Escape_time_kernel&&) = default;
+
+  // Each pixel starts at z = real[n] + imaginary * i.  When k is null the pixel is also the constant (Mandlebrot),
+  // otherwise every pixel uses *k as the constant (Julia).  Counts are uint32_t or, for max_iterations below
+  // UINT16_MAX, uint16_t.  When smooth isn't null it also receives the fractional escape count of each pixel (see
+  // smooth_iterations).
+  template <typename Count>
+  void invoke(const double* real,
+              double imaginary,
+              const std::complex<double>* k,
+              size_t count,
+              size_t max_iterations,
+              Count* iterations,
+              const std::atomic<bool>& cancel_token,
+              Lane_statistics* statistics = nullptr,
+              float* smooth = nullptr) const
+  {
+    auto operation = Row_operation_<double, Count>{real, imaginary, k, count, max_iterations, iterations, smooth, m_periodicity_tolerance, cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  template <typename Count>
+  void operator()(const double* real,
+                  double imaginary,
+                  const std::complex<double>* k,
+                  size_t count,
+                  size_t max_iterations,
+                  Count* iterations,
+                  const std::atomic<bool>& cancel_token,
+                  Lane_statistics* statistics = nullptr,
+                  float* smooth = nullptr) const
+  {
+    invoke(real, imaginary, k, count, max_iterations, iterations, cancel_token, statistics, smooth);
+  }
+
+  // Single precision variant, twice as many lanes per register for views shallow enough for floats.
+  template <typename Count>
+  void invoke(const float* real,
+              float imaginary,
+              const std::complex<float>* k,
+              size_t count,
+              size_t max_iterations,
+              Count* iterations,
+              const std::atomic<bool>& cancel_token,
+              Lane_statistics* statistics = nullptr,
+              float* smooth = nullptr) const
+  {
+    auto operation = Row_operation_<float, Count>{real, imaginary, k, count, max_iterations, iterations, smooth, static_cast<float>(m_periodicity_tolerance), cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  // Streams every pixel of a width x height tile through the lanes.  Pixel (x, y) starts at real[x] + imaginary[y] * i
+  // and its result is written to iterations[x + y * stride].  As soon as a lane escapes or reaches max_iterations
+  // it stores its result and picks up the next pending pixel, so lanes don't idle behind a slow neighbour.  With
+  // skip_resolved set, only pixels whose entry is Escape_time_kernel::pending are iterated.
+  template <typename Count>
+  void invoke_streaming(const double* real,
+                        size_t width,
+                        const double* imaginary,
+                        size_t height,
+                        const std::complex<double>* k,
+                        size_t max_iterations,
+                        Count* iterations,
+                        size_t stride,
+                        const std::atomic<bool>& cancel_token,
+                        Lane_statistics* statistics = nullptr,
+                        float* smooth = nullptr) const
+  {
+    auto operation = Streaming_operation_<double, Count>{real, width, imaginary, height, k, max_iterations, iterations, smooth, stride, m_skip_resolved, m_periodicity_tolerance, cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  template <typename Count>
+  void invoke_streaming(const float* real,
+                        size_t width,
+                        const float* imaginary,
+                        size_t height,
+                        const std::complex<float>* k,
+                        size_t max_iterations,
+                        Count* iterations,
+                        size_t stride,
+                        const std::atomic<bool>& cancel_token,
+                        Lane_statistics* statistics = nullptr,
+                        float* smooth = nullptr) const
+  {
+    auto operation = Streaming_operation_<float, Count>{real, width, imaginary, height, k, max_iterations, iterations, smooth, stride, m_skip_resolved, static_cast<float>(m_periodicity_tolerance), cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  // Mandlebrot iteration of a row for coordinates carrying more precision than a double (Double_double or
+  // Quad_double).  Each lane holds one pixel's components and only the escape test is done on the leading one.
+  template <typename Number, typename Count>
+  void invoke_extended(const Number* real,
+                       const Number& imaginary,
+                       size_t count,
+                       size_t max_iterations,
+                       Count* iterations,
+                       const std::atomic<bool>& cancel_token,
+                       Lane_statistics* statistics = nullptr) const
+  {
+    auto operation = Extended_row_operation_<Number, Count>{real, imaginary, count, max_iterations, iterations, cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  // Policy based tile loop for any formula (see formula.h).  Every combination of formula, escape test, coloring and
+  // cancel check interval compiles to its own fully inlined loop, so a formula costs nothing it doesn't use.  Pixel
+  // (x, y) starts at real[x] + imaginary[y] * i, constant is handed to Formula::start (the k of Julia_formula) and the
+  // result lands in iterations[x + y * stride], plus smooth[x + y * stride] with Smooth_coloring.  The cancel token
+  // is checked every Cancel_check_interval iterations.
+  template <typename Formula, typename Escape, typename Coloring, size_t Cancel_check_interval, typename Real, typename Count>
+  void invoke_formula(const Real* real,
+                      size_t width,
+                      const Real* imaginary,
+                      size_t height,
+                      std::complex<Real> constant,
+                      size_t max_iterations,
+                      Count* iterations,
+                      float* smooth,
+                      size_t stride,
+                      const std::atomic<bool>& cancel_token,
+                      Lane_statistics* statistics = nullptr) const
+  {
+    auto operation = Formula_operation_<Real, Count, Formula, Escape, Coloring, Cancel_check_interval>{real,
+                                                                                                      width,
+                                                                                                      imaginary,
+                                                                                                      height,
+                                                                                                      constant,
+                                                                                                      max_iterations,
+                                                                                                      iterations,
+                                                                                                      smooth,
+                                                                                                      stride,
+                                                                                                      cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  // Tile loop that also carries the derivative dz/dc (dz/dz0 when k isn't null) alongside z, for the exterior
+  // distance estimate 2 |z| ln|z| / |dz|.  Pixel (x, y) starts at real[x] + imaginary[y] * i, its escape count lands
+  // in iterations[x + y * stride], identical to invoke, and its distance to the set in distance[x + y * stride].
+  // Pixels that never escape get a distance of zero.  Escaped lanes keep iterating until |z| passes
+  // s_distance_radius_squared, which sharpens the estimate, or until the iterations run out.
+  template <typename Count>
+  void invoke_distance(const double* real,
+                       size_t width,
+                       const double* imaginary,
+                       size_t height,
+                       const std::complex<double>* k,
+                       size_t max_iterations,
+                       Count* iterations,
+                       float* distance,
+                       size_t stride,
+                       const std::atomic<bool>& cancel_token,
+                       Lane_statistics* statistics = nullptr) const
+  {
+    auto operation = Distance_operation_<Count>{real, width, imaginary, height, k, max_iterations, iterations, distance, stride, cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  // Continues every pixel of a width x height tile from where an earlier call stopped.  The state of pixel (x, y) is
+  // z_real/z_imaginary[x + y * stride] and progress[x + y * stride], the iterations done (see Iteration_state):
+  // unset pixels start at z = real[x] + imaginary[y] * i, interior ones are reported as never escaping, escaped ones
+  // keep their count and the others are iterated from their z until they escape or reach max_iterations.  Counts
+  // and smooth counts are identical to invoke from scratch and the state is updated for the next call, even when
+  // canceled.  Only the pixels still iterating are packed into the lanes.
+  template <typename Count>
+  void invoke_resume(const double* real,
+                     size_t width,
+                     const double* imaginary,
+                     size_t height,
+                     const std::complex<double>* k,
+                     size_t max_iterations,
+                     double* z_real,
+                     double* z_imaginary,
+                     uint32_t* progress,
+                     Count* iterations,
+                     float* smooth,
+                     size_t stride,
+                     const std::atomic<bool>& cancel_token,
+                     Lane_statistics* statistics = nullptr) const
+  {
+    auto operation = Resume_operation_<Count>{real, width, imaginary, height, k, max_iterations, z_real, z_imaginary, progress, iterations, smooth, stride, cancel_token};
+    dispatch_(operation);
+    record_(statistics, operation.active_lane_iterations, operation.lane_iterations);
+  }
+
+  // Distance to the set of a pixel whose z and derivative had the given squared magnitudes when it stopped.
+  static float distance_estimate(size_t iterations, double norm, double derivative_norm, size_t max_iterations)
+  {
+    if (iterations >= max_iterations || !(norm > 4) || !(derivative_norm > 0))
+    {
+      return 0.0f;
+    }
+
+    // 2 |z| ln|z| / |dz| == sqrt(|z|^2 / |dz|^2) ln(|z|^2)
+    return static_cast<float>(std::sqrt(norm / derivative_norm) * std::log(norm));
+  }
+
+  Instruction_set instruction_set() const
+  {
+    return m_instruction_set;
+  }
+
+  bool skip_resolved() const
+  {
+    return m_skip_resolved;
+  }
+
+  void set_skip_resolved(bool skip_resolved)
+  {
+    m_skip_resolved = skip_resolved;
+  }
+
+  double periodicity_tolerance() const
+  {
+    return m_periodicity_tolerance;
+  }
+
+  // Pixels whose orbit returns within the tolerance of an earlier point are reported as never escaping.  Zero
+  // disables the check.
+  void set_periodicity_tolerance(double tolerance)
+  {
+    m_periodicity_tolerance = tolerance;
+  }
+
+  // Tolerance for a view whose neighbouring pixels are pixel_spacing apart.
+  static double periodicity_tolerance(double pixel_spacing)
+  {
+    return pixel_spacing * s_periodicity_tolerance_factor;
+  }
+
+  // Continuous escape count of a pixel that escaped after iteration iterations with |z|^2 = norm, which removes the
+  // banding between neighbouring counts.  Pixels that never escaped keep max_iterations.
+  static float smooth_iterations(size_t iterations, double norm, size_t max_iterations)
+  {
+    if (iterations >= max_iterations || !(norm > 4))
+    {
+      return static_cast<float>(iterations >= max_iterations ? max_iterations : iterations);
+    }
+
+    auto smooth = static_cast<double>(iterations) + 1.0 - std::log2(0.5 * std::log2(norm));
+    return static_cast<float>(std::max(smooth, 0.0));
+  }
+
+  static Instruction_set supported_instruction_set()
+  {
+    static const auto instruction_set = detect_instruction_set_();
+    return instruction_set;
+  }
+
+private:
+  static constexpr size_t s_cancel_check_interval = 256;
+  static constexpr size_t s_block_iterations = 8;
+  static constexpr double s_periodicity_tolerance_factor = 1.0 / 1024.0;
+  // |z|^2 at which invoke_distance stops following an escaped lane, the larger the radius the closer the estimate.
+  static constexpr double s_distance_radius_squared = 1e12;
+
+  static Instruction_set detect_instruction_set_()
+  {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      return Instruction_set::avx512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+      return Instruction_set::avx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+      return Instruction_set::sse2;
+    }
+#endif
+    return Instruction_set::portable;
+  }
+
+  static void record_(Lane_statistics* statistics, uint64_t active_lane_iterations, uint64_t lane_iterations)
+  {
+    if (!statistics)
+    {
+      return;
+    }
+
+    statistics->active_lane_iterations += active_lane_iterations;
+    statistics->lane_iterations += lane_iterations;
+  }
+
+  // Operations provide run_portable() and run<Bytes>(), the latter being written once against GCC/Clang vector
+  // extensions of the given register width.  It is always inlined so each ISA entry point compiles it with its own
+  // target features.
+  template <typename Operation>
+  void dispatch_(Operation& operation) const
+  {
+    switch (m_instruction_set)
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      case Instruction_set::avx512:
+      {
+        run_avx512_(operation);
+      } break;
+      case Instruction_set::avx2:
+      {
+        run_avx2_(operation);
+      } break;
+      case Instruction_set::sse2:
+      {
+        run_sse2_(operation);
+      } break;
+#endif
+      default:
+      {
+        operation.run_portable();
+      } break;
+    }
+  }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  template <typename Operation>
+  __attribute__((target("sse2"))) static void run_sse2_(Operation& operation)
+  {
+    operation.template run<16>();
+  }
+
+  template <typename Operation>
+  __attribute__((target("avx2"))) static void run_avx2_(Operation& operation)
+  {
+    operation.template run<32>();
+  }
+
+  template <typename Operation>
+  __attribute__((target("avx512f"))) static void run_avx512_(Operation& operation)
+  {
+    operation.template run<64>();
+  }
+
+  template <typename Real, size_t Bytes>
+  struct Lanes_
+  {
+    static constexpr size_t count = Bytes / sizeof(Real);
+    using Integer = typename std::conditional<sizeof(Real) == sizeof(int64_t), int64_t, int32_t>::type;
+    typedef Real Vector __attribute__((vector_size(Bytes)));
+    using Mask = decltype(Vector{} <= Vector{});
+  };
+
+  template <size_t Bytes, typename Mask>
+  __attribute__((always_inline)) static inline bool any_(const Mask& mask)
+  {
+    uint64_t words[Bytes / sizeof(uint64_t)];
+    std::memcpy(words, &mask, Bytes);
+    auto result = uint64_t{0};
+    for (auto word : words)
+    {
+      result |= word;
+    }
+    return result != 0;
+  }
+#endif
+
+  // Scalar reference loop for a single pixel, shared by the portable paths.
+  // Leaves |z|^2 at the last escape test in norm.
+  template <typename Real>
+  static size_t iterate_(std::complex<Real> z,
+                         std::complex<Real> c,
+                         size_t max_iterations,
+                         Real tolerance,
+                         const std::atomic<bool>& cancel_token,
+                         Real& norm)
+  {
+    auto saved = z;
+    auto checkpoint = size_t{1};
+    auto i = size_t{0};
+    for (; i < max_iterations; ++i)
+    {
+      norm = z.real() * z.real() + z.imag() * z.imag();
+      if (norm > 4)
+      {
+        break;
+      }
+
+      z = z * z + c;
+
+      if (tolerance > 0)
+      {
+        if (std::norm(z - saved) < tolerance * tolerance)
+        {
+          return max_iterations;
+        }
+
+        if (i + 1 == checkpoint)
+        {
+          saved = z;
+          checkpoint *= 2;
+        }
+      }
+
+      if (i % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    return i;
+  }
+
+  template <typename Real, typename Count>
+  struct Row_operation_
+  {
+    const Real* real;
+    Real imaginary;
+    const std::complex<Real>* k;
+    size_t count;
+    size_t max_iterations;
+    Count* iterations;
+    float* smooth;
+    Real tolerance;
+    const std::atomic<bool>& cancel_token;
+    uint64_t active_lane_iterations{0};
+    uint64_t lane_iterations{0};
+
+    void run_portable()
+    {
+      for (size_t n = 0; n < count; ++n)
+      {
+        if (cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+
+        auto z = std::complex<Real>{real[n], imaginary};
+        auto norm = Real{};
+        auto i = iterate_(z, k ? *k : z, max_iterations, tolerance, cancel_token, norm);
+        iterations[n] = static_cast<Count>(i);
+        if (smooth)
+        {
+          smooth[n] = smooth_iterations(i, norm, max_iterations);
+        }
+        active_lane_iterations += i;
+        lane_iterations += i;
+      }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    template <size_t Bytes>
+    __attribute__((always_inline)) inline void run()
+    {
+      if (tolerance > 0)
+      {
+        run_<Bytes, true>();
+      }
+      else
+      {
+        run_<Bytes, false>();
+      }
+    }
+
+    template <size_t Bytes, bool Periodicity>
+    __attribute__((always_inline)) inline void run_()
+    {
+      if (smooth)
+      {
+        run_<Bytes, Periodicity, true>();
+      }
+      else
+      {
+        run_<Bytes, Periodicity, false>();
+      }
+    }
+
+    template <size_t Bytes, bool Periodicity, bool Smooth>
+    __attribute__((always_inline)) inline void run_()
+    {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+      using Vector = typename Lanes_<Real, Bytes>::Vector;
+      using Mask = typename Lanes_<Real, Bytes>::Mask;
+      constexpr auto lanes = Lanes_<Real, Bytes>::count;
+
+      const auto four = Vector{} + 4;
+      const auto limit = Mask{} + static_cast<typename Lanes_<Real, Bytes>::Integer>(max_iterations);
+      const auto tolerance_squared = Vector{} + tolerance * tolerance;
+      for (size_t n = 0; n < count; n += lanes)
+      {
+        if (cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+
+        auto z_real = Vector{};
+        auto z_imaginary = Vector{} + imaginary;
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+          // The last group is padded by repeating its final pixel.
+          z_real[lane] = real[std::min(n + lane, count - 1)];
+        }
+        auto c_real = k ? Vector{} + k->real() : z_real;
+        auto c_imaginary = k ? Vector{} + k->imag() : z_imaginary;
+
+        auto escape = Mask{};
+        auto active = escape == escape;
+        auto periodic = Mask{};
+        auto saved_real = z_real;
+        auto saved_imaginary = z_imaginary;
+        auto checkpoint = Mask{} + 1;
+        auto escape_norm = Vector{};
+        for (size_t i = 0; i < max_iterations && any_<Bytes>(active); i += s_block_iterations)
+        {
+          for (size_t block = 0; block < s_block_iterations; ++block)
+          {
+            auto real_squared = z_real * z_real;
+            auto imaginary_squared = z_imaginary * z_imaginary;
+            auto norm = real_squared + imaginary_squared;
+            if (Smooth)
+            {
+              // Frozen at the norm that failed the escape test once the lane is done.
+              escape_norm = active ? norm : escape_norm;
+            }
+            active &= (norm <= four);
+
+            // Active lanes are all ones, so this counts one more iteration for each of them.  Lanes that are
+            // done keep iterating until the end of the block but their count is frozen.
+            escape -= active;
+            z_imaginary = (z_real * z_imaginary + z_real * z_imaginary) + c_imaginary;
+            z_real = (real_squared - imaginary_squared) + c_real;
+
+            if (Periodicity)
+            {
+              check_periodicity_<Vector, Mask>(z_real, z_imaginary, saved_real, saved_imaginary, checkpoint, escape, active, periodic, tolerance_squared);
+            }
+          }
+          lane_iterations += lanes * s_block_iterations;
+
+          if ((i / s_block_iterations) % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+          {
+            return;
+          }
+        }
+
+        // The last block can overshoot max_iterations and lanes caught in a cycle never escape.
+        escape = escape < limit ? escape : limit;
+        escape = periodic ? limit : escape;
+
+        for (size_t lane = 0; lane < lanes && n + lane < count; ++lane)
+        {
+          iterations[n + lane] = static_cast<Count>(escape[lane]);
+          active_lane_iterations += iterations[n + lane];
+          if (Smooth)
+          {
+            smooth[n + lane] = smooth_iterations(static_cast<size_t>(escape[lane]), escape_norm[lane], max_iterations);
+          }
+        }
+      }
+    }
+#endif
+  };
+
+  template <typename Real, typename Count>
+  struct Streaming_operation_
+  {
+    const Real* real;
+    size_t width;
+    const Real* imaginary;
+    size_t height;
+    const std::complex<Real>* k;
+    size_t max_iterations;
+    Count* iterations;
+    float* smooth;
+    size_t stride;
+    bool skip_resolved;
+    Real tolerance;
+    const std::atomic<bool>& cancel_token;
+    uint64_t active_lane_iterations{0};
+    uint64_t lane_iterations{0};
+
+    void run_portable()
+    {
+      // A single lane is never idle, so streaming only applies to the vector paths.
+      for (size_t y = 0; y < height; ++y)
+      {
+        for (size_t x = 0; x < width; ++x)
+        {
+          if (skip_resolved && iterations[x + y * stride] != static_cast<Count>(pending))
+          {
+            continue;
+          }
+
+          auto z = std::complex<Real>{real[x], imaginary[y]};
+          auto norm = Real{};
+          auto i = iterate_(z, k ? *k : z, max_iterations, tolerance, cancel_token, norm);
+          iterations[x + y * stride] = static_cast<Count>(i);
+          if (smooth)
+          {
+            smooth[x + y * stride] = smooth_iterations(i, norm, max_iterations);
+          }
+          active_lane_iterations += i;
+          lane_iterations += i;
+        }
+
+        if (cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+      }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    template <size_t Bytes>
+    __attribute__((always_inline)) inline void run()
+    {
+      if (tolerance > 0)
+      {
+        run_<Bytes, true>();
+      }
+      else
+      {
+        run_<Bytes, false>();
+      }
+    }
+
+    template <size_t Bytes, bool Periodicity>
+    __attribute__((always_inline)) inline void run_()
+    {
+      if (smooth)
+      {
+        run_<Bytes, Periodicity, true>();
+      }
+      else
+      {
+        run_<Bytes, Periodicity, false>();
+      }
+    }
+
+    template <size_t Bytes, bool Periodicity, bool Smooth>
+    __attribute__((always_inline)) inline void run_()
+    {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+      using Vector = typename Lanes_<Real, Bytes>::Vector;
+      using Mask = typename Lanes_<Real, Bytes>::Mask;
+      constexpr auto lanes = Lanes_<Real, Bytes>::count;
+
+      const auto four = Vector{} + 4;
+      const auto limit = Mask{} + static_cast<typename Lanes_<Real, Bytes>::Integer>(max_iterations);
+      const auto tolerance_squared = Vector{} + tolerance * tolerance;
+      const auto total = width * height;
+
+      auto z_real = Vector{};
+      auto z_imaginary = Vector{};
+      auto c_real = Vector{};
+      auto c_imaginary = Vector{};
+      auto escape = Mask{};
+      auto active = Mask{};
+      auto periodic = Mask{};
+      auto saved_real = Vector{};
+      auto saved_imaginary = Vector{};
+      auto checkpoint = Mask{};
+      auto escape_norm = Vector{};
+      size_t pixel[lanes];
+      auto next = size_t{0};
+      auto busy_lanes = size_t{0};
+
+      // Every lane starts out done and is loaded by the refill below.
+      for (size_t lane = 0; lane < lanes; ++lane)
+      {
+        pixel[lane] = total;
+      }
+
+      for (size_t block = 1; ; ++block)
+      {
+        // Lanes can overshoot max_iterations by part of a block, their count is clamped when they are stored.
+        auto done = ~active | (escape >= limit);
+        if (any_<Bytes>(done))
+        {
+          // Store the finished lanes and load the next pending pixels into them, retiring lanes once the tile
+          // is exhausted.
+          for (size_t lane = 0; lane < lanes; ++lane)
+          {
+            if (!done[lane])
+            {
+              continue;
+            }
+
+            if (pixel[lane] != total)
+            {
+              auto result = periodic[lane] ? max_iterations : std::min(static_cast<size_t>(escape[lane]), max_iterations);
+              auto index = pixel[lane] % width + (pixel[lane] / width) * stride;
+              iterations[index] = static_cast<Count>(result);
+              if (Smooth)
+              {
+                smooth[index] = smooth_iterations(result, escape_norm[lane], max_iterations);
+              }
+              active_lane_iterations += result;
+              pixel[lane] = total;
+              active[lane] = 0;
+              --busy_lanes;
+            }
+
+            while (skip_resolved && next != total && iterations[next % width + (next / width) * stride] != static_cast<Count>(pending))
+            {
+              ++next;
+            }
+
+            if (next == total)
+            {
+              continue;
+            }
+
+            pixel[lane] = next++;
+            z_real[lane] = real[pixel[lane] % width];
+            z_imaginary[lane] = imaginary[pixel[lane] / width];
+            c_real[lane] = k ? k->real() : z_real[lane];
+            c_imaginary[lane] = k ? k->imag() : z_imaginary[lane];
+            escape[lane] = 0;
+            active[lane] = -1;
+            periodic[lane] = 0;
+            saved_real[lane] = z_real[lane];
+            saved_imaginary[lane] = z_imaginary[lane];
+            checkpoint[lane] = 1;
+            escape_norm[lane] = 0;
+            ++busy_lanes;
+          }
+
+          if (busy_lanes == 0)
+          {
+            return;
+          }
+        }
+
+        for (size_t i = 0; i < s_block_iterations; ++i)
+        {
+          auto real_squared = z_real * z_real;
+          auto imaginary_squared = z_imaginary * z_imaginary;
+          auto norm = real_squared + imaginary_squared;
+          if (Smooth)
+          {
+            escape_norm = active ? norm : escape_norm;
+          }
+          active &= (norm <= four);
+          escape -= active;
+          z_imaginary = (z_real * z_imaginary + z_real * z_imaginary) + c_imaginary;
+          z_real = (real_squared - imaginary_squared) + c_real;
+
+          if (Periodicity)
+          {
+            check_periodicity_<Vector, Mask>(z_real, z_imaginary, saved_real, saved_imaginary, checkpoint, escape, active, periodic, tolerance_squared);
+          }
+        }
+        lane_iterations += lanes * s_block_iterations;
+
+        if (block % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+      }
+    }
+#endif
+  };
+
+  template <typename Number, typename Count>
+  struct Extended_row_operation_
+  {
+    const Number* real;
+    const Number& imaginary;
+    size_t count;
+    size_t max_iterations;
+    Count* iterations;
+    const std::atomic<bool>& cancel_token;
+    uint64_t active_lane_iterations{0};
+    uint64_t lane_iterations{0};
+
+    void run_portable()
+    {
+      for (size_t n = 0; n < count; ++n)
+      {
+        if (cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+
+        auto z_real = real[n];
+        auto z_imaginary = imaginary;
+        auto i = size_t{0};
+        for (; i < max_iterations; ++i)
+        {
+          if (z_real[0] * z_real[0] + z_imaginary[0] * z_imaginary[0] > 4)
+          {
+            break;
+          }
+
+          auto real_squared = z_real * z_real;
+          auto imaginary_squared = z_imaginary * z_imaginary;
+          auto product = z_real * z_imaginary;
+          z_imaginary = product + product + imaginary;
+          z_real = real_squared - imaginary_squared + real[n];
+
+          if (i % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+          {
+            break;
+          }
+        }
+        iterations[n] = static_cast<Count>(i);
+        active_lane_iterations += i;
+        lane_iterations += i;
+      }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    template <size_t Bytes>
+    __attribute__((always_inline)) inline void run()
+    {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+      using Vector = typename Lanes_<double, Bytes>::Vector;
+      using Mask = typename Lanes_<double, Bytes>::Mask;
+      using Lane_number = typename Number::template rebind<Vector>;
+      constexpr auto lanes = Lanes_<double, Bytes>::count;
+
+      const auto four = Vector{} + 4;
+      const auto limit = Mask{} + static_cast<typename Lanes_<double, Bytes>::Integer>(max_iterations);
+      for (size_t n = 0; n < count; n += lanes)
+      {
+        if (cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+
+        auto c_real = Lane_number{};
+        auto c_imaginary = Lane_number{};
+        for (size_t component = 0; component < Number::size; ++component)
+        {
+          for (size_t lane = 0; lane < lanes; ++lane)
+          {
+            // The last group is padded by repeating its final pixel.
+            c_real[component][lane] = real[std::min(n + lane, count - 1)][component];
+            c_imaginary[component][lane] = imaginary[component];
+          }
+        }
+        auto z_real = c_real;
+        auto z_imaginary = c_imaginary;
+
+        auto escape = Mask{};
+        auto active = escape == escape;
+        for (size_t i = 0; i < max_iterations && any_<Bytes>(active); i += s_block_iterations)
+        {
+          for (size_t block = 0; block < s_block_iterations; ++block)
+          {
+            auto leading_real = z_real[0];
+            auto leading_imaginary = z_imaginary[0];
+            active &= (leading_real * leading_real + leading_imaginary * leading_imaginary <= four);
+            escape -= active;
+
+            auto real_squared = z_real * z_real;
+            auto imaginary_squared = z_imaginary * z_imaginary;
+            auto product = z_real * z_imaginary;
+            z_imaginary = product + product + c_imaginary;
+            z_real = real_squared - imaginary_squared + c_real;
+          }
+          lane_iterations += lanes * s_block_iterations;
+
+          if ((i / s_block_iterations) % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+          {
+            return;
+          }
+        }
+
+        escape = escape < limit ? escape : limit;
+
+        for (size_t lane = 0; lane < lanes && n + lane < count; ++lane)
+        {
+          iterations[n + lane] = static_cast<Count>(escape[lane]);
+          active_lane_iterations += iterations[n + lane];
+        }
+      }
+    }
+#endif
+  };
+
+  template <typename Real, typename Count, typename Formula, typename Escape, typename Coloring, size_t Cancel_check_interval>
+  struct Formula_operation_
+  {
+    static_assert(Cancel_check_interval > 0, "The cancel check interval must be positive");
+
+    const Real* real;
+    size_t width;
+    const Real* imaginary;
+    size_t height;
+    std::complex<Real> constant;
+    size_t max_iterations;
+    Count* iterations;
+    float* smooth;
+    size_t stride;
+    const std::atomic<bool>& cancel_token;
+    uint64_t active_lane_iterations{0};
+    uint64_t lane_iterations{0};
+
+    void run_portable()
+    {
+      const auto k_real = constant.real();
+      const auto k_imaginary = constant.imag();
+      for (size_t y = 0; y < height; ++y)
+      {
+        for (size_t x = 0; x < width; ++x)
+        {
+          auto z_real = real[x];
+          auto z_imaginary = imaginary[y];
+          auto c_real = Real{};
+          auto c_imaginary = Real{};
+          Formula::start(z_real, z_imaginary, k_real, k_imaginary, c_real, c_imaginary);
+
+          auto i = size_t{0};
+          for (; i < max_iterations; ++i)
+          {
+            if (!Escape::bounded(z_real, z_imaginary))
+            {
+              break;
+            }
+
+            Formula::step(z_real, z_imaginary, c_real, c_imaginary);
+
+            if (i % Cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+            {
+              break;
+            }
+          }
+
+          store_(x + y * stride, i, z_real * z_real + z_imaginary * z_imaginary, std::integral_constant<bool, Coloring::smooth>{});
+          active_lane_iterations += i;
+          lane_iterations += i;
+        }
+
+        if (cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+      }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    template <size_t Bytes>
+    __attribute__((always_inline)) inline void run()
+    {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+      using Vector = typename Lanes_<Real, Bytes>::Vector;
+      using Mask = typename Lanes_<Real, Bytes>::Mask;
+      constexpr auto lanes = Lanes_<Real, Bytes>::count;
+
+      const auto limit = Mask{} + static_cast<typename Lanes_<Real, Bytes>::Integer>(max_iterations);
+      const auto k_real = Vector{} + constant.real();
+      const auto k_imaginary = Vector{} + constant.imag();
+      for (size_t y = 0; y < height; ++y)
+      {
+        for (size_t n = 0; n < width; n += lanes)
+        {
+          auto z_real = Vector{};
+          auto z_imaginary = Vector{} + imaginary[y];
+          for (size_t lane = 0; lane < lanes; ++lane)
+          {
+            // The last group is padded by repeating its final pixel.
+            z_real[lane] = real[std::min(n + lane, width - 1)];
+          }
+          auto c_real = Vector{};
+          auto c_imaginary = Vector{};
+          Formula::start(z_real, z_imaginary, k_real, k_imaginary, c_real, c_imaginary);
+
+          auto escape = Mask{};
+          auto active = escape == escape;
+          auto escape_norm = Vector{};
+          for (size_t i = 0; i < max_iterations && any_<Bytes>(active); i += s_block_iterations)
+          {
+            for (size_t block = 0; block < s_block_iterations; ++block)
+            {
+              if (Coloring::smooth)
+              {
+                // Frozen at the norm of the first z that failed the escape test.
+                escape_norm = active ? z_real * z_real + z_imaginary * z_imaginary : escape_norm;
+              }
+              active &= Escape::bounded(z_real, z_imaginary);
+              escape -= active;
+              Formula::step(z_real, z_imaginary, c_real, c_imaginary);
+            }
+            lane_iterations += lanes * s_block_iterations;
+
+            if (i % Cancel_check_interval < s_block_iterations && cancel_token.load(std::memory_order_relaxed))
+            {
+              return;
+            }
+          }
+
+          // The last block can overshoot max_iterations.
+          escape = escape < limit ? escape : limit;
+
+          for (size_t lane = 0; lane < lanes && n + lane < width; ++lane)
+          {
+            store_(n + lane + y * stride, static_cast<size_t>(escape[lane]), escape_norm[lane], std::integral_constant<bool, Coloring::smooth>{});
+            active_lane_iterations += static_cast<size_t>(escape[lane]);
+          }
+        }
+      }
+    }
+#endif
+
+    void store_(size_t index, size_t i, double norm, std::true_type)
+    {
+      iterations[index] = static_cast<Count>(i);
+      if (smooth)
+      {
+        smooth[index] = Coloring::template smooth_iterations<Formula, Escape>(i, norm, max_iterations);
+      }
+    }
+
+    void store_(size_t index, size_t i, double, std::false_type)
+    {
+      iterations[index] = static_cast<Count>(i);
+    }
+  };
+
+  struct Pixel_
+  {
+    size_t x;
+    size_t y;
+  };
+
+  template <typename Count>
+  struct Resume_operation_
+  {
+    const double* real;
+    size_t width;
+    const double* imaginary;
+    size_t height;
+    const std::complex<double>* k;
+    size_t max_iterations;
+    double* z_real;
+    double* z_imaginary;
+    uint32_t* progress;
+    Count* iterations;
+    float* smooth;
+    size_t stride;
+    const std::atomic<bool>& cancel_token;
+    uint64_t active_lane_iterations{0};
+    uint64_t lane_iterations{0};
+    // Pixels that still have to be iterated.
+    std::vector<Pixel_> pending{};
+
+    void run_portable()
+    {
+      if (!prepare_())
+      {
+        return;
+      }
+
+      for (const auto& pixel : pending)
+      {
+        auto index = pixel.x + pixel.y * stride;
+        auto z = std::complex<double>{z_real[index], z_imaginary[index]};
+        auto c = k ? *k : std::complex<double>{real[pixel.x], imaginary[pixel.y]};
+        auto i = static_cast<size_t>(progress[index]);
+        auto start = i;
+        auto canceled = false;
+        for (; i < max_iterations; ++i)
+        {
+          if (z.real() * z.real() + z.imag() * z.imag() > 4)
+          {
+            break;
+          }
+
+          z = std::complex<double>{(z.real() * z.real() - z.imag() * z.imag()) + c.real(),
+                                   (z.real() * z.imag() + z.real() * z.imag()) + c.imag()};
+
+          if ((i - start) % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+          {
+            canceled = true;
+            ++i;
+            break;
+          }
+        }
+
+        store_(index, z.real(), z.imag(), i);
+        active_lane_iterations += i - start;
+        lane_iterations += i - start;
+        if (canceled)
+        {
+          return;
+        }
+      }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    template <size_t Bytes>
+    __attribute__((always_inline)) inline void run()
+    {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+      using Vector = typename Lanes_<double, Bytes>::Vector;
+      using Mask = typename Lanes_<double, Bytes>::Mask;
+      constexpr auto lanes = Lanes_<double, Bytes>::count;
+
+      if (!prepare_())
+      {
+        return;
+      }
+
+      const auto limit = Mask{} + static_cast<typename Lanes_<double, Bytes>::Integer>(max_iterations);
+      const auto last_block = limit - static_cast<typename Lanes_<double, Bytes>::Integer>(s_block_iterations);
+      for (size_t n = 0; n < pending.size(); n += lanes)
+      {
+        auto current_real = Vector{};
+        auto current_imaginary = Vector{};
+        auto c_real = Vector{};
+        auto c_imaginary = Vector{};
+        auto escape = Mask{};
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+          // The last group is padded by repeating its final pixel.
+          const auto& pixel = pending[std::min(n + lane, pending.size() - 1)];
+          auto index = pixel.x + pixel.y * stride;
+          current_real[lane] = z_real[index];
+          current_imaginary[lane] = z_imaginary[index];
+          c_real[lane] = k ? k->real() : real[pixel.x];
+          c_imaginary[lane] = k ? k->imag() : imaginary[pixel.y];
+          escape[lane] = progress[index];
+        }
+        const auto start = escape;
+        auto saved_real = current_real;
+        auto saved_imaginary = current_imaginary;
+
+        auto active = escape == escape;
+        auto canceled = false;
+        for (size_t i = 0; any_<Bytes>(active); i += s_block_iterations)
+        {
+          // Lanes resume at different counts, only the blocks in which one of them can reach max_iterations test
+          // the limit on every iteration.
+          if (any_<Bytes>(active & (escape > last_block)))
+          {
+            iterate_block_<true>(current_real, current_imaginary, saved_real, saved_imaginary, c_real, c_imaginary, escape, active, limit);
+          }
+          else
+          {
+            iterate_block_<false>(current_real, current_imaginary, saved_real, saved_imaginary, c_real, c_imaginary, escape, active, limit);
+          }
+          lane_iterations += lanes * s_block_iterations;
+
+          if ((i / s_block_iterations) % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+          {
+            canceled = true;
+            break;
+          }
+        }
+
+        for (size_t lane = 0; lane < lanes && n + lane < pending.size(); ++lane)
+        {
+          store_(pending[n + lane].x + pending[n + lane].y * stride, saved_real[lane], saved_imaginary[lane], static_cast<size_t>(escape[lane]));
+          active_lane_iterations += static_cast<size_t>(escape[lane] - start[lane]);
+        }
+
+        if (canceled)
+        {
+          return;
+        }
+      }
+    }
+
+    template <bool Limited, typename Vector, typename Mask>
+    __attribute__((always_inline)) static inline void iterate_block_(Vector& current_real,
+                                                                     Vector& current_imaginary,
+                                                                     Vector& saved_real,
+                                                                     Vector& saved_imaginary,
+                                                                     const Vector& c_real,
+                                                                     const Vector& c_imaginary,
+                                                                     Mask& escape,
+                                                                     Mask& active,
+                                                                     const Mask& limit)
+    {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+      const auto four = Vector{} + 4;
+      for (size_t block = 0; block < s_block_iterations; ++block)
+      {
+        auto real_squared = current_real * current_real;
+        auto imaginary_squared = current_imaginary * current_imaginary;
+        if (Limited)
+        {
+          active &= (escape < limit);
+        }
+        active &= (real_squared + imaginary_squared <= four);
+        escape -= active;
+        current_imaginary = (current_real * current_imaginary + current_real * current_imaginary) + c_imaginary;
+        current_real = (real_squared - imaginary_squared) + c_real;
+
+        // Lanes that are done keep iterating until the end of the block, the z they stopped at is the state the next
+        // call resumes from.  Saving it apart keeps the select off the dependency chain of the iteration.
+        saved_real = active ? current_real : saved_real;
+        saved_imaginary = active ? current_imaginary : saved_imaginary;
+      }
+    }
+#endif
+
+    // Reports the pixels that are already resolved and lists the others in pending.
+    bool prepare_()
+    {
+      pending.clear();
+      for (size_t y = 0; y < height; ++y)
+      {
+        for (size_t x = 0; x < width; ++x)
+        {
+          auto index = x + y * stride;
+          if (progress[index] == Iteration_state::unset)
+          {
+            z_real[index] = real[x];
+            z_imaginary[index] = imaginary[y];
+            progress[index] = 0;
+          }
+
+          if (progress[index] == Iteration_state::interior)
+          {
+            iterations[index] = static_cast<Count>(max_iterations);
+            if (smooth)
+            {
+              smooth[index] = static_cast<float>(max_iterations);
+            }
+            continue;
+          }
+
+          auto norm = z_real[index] * z_real[index] + z_imaginary[index] * z_imaginary[index];
+          if (norm > 4 || progress[index] >= max_iterations)
+          {
+            report_(index, norm, progress[index]);
+            continue;
+          }
+
+          pending.push_back(Pixel_{x, y});
+        }
+      }
+      return !pending.empty();
+    }
+
+    void store_(size_t index, double real_part, double imaginary_part, size_t i)
+    {
+      z_real[index] = real_part;
+      z_imaginary[index] = imaginary_part;
+      progress[index] = static_cast<uint32_t>(i);
+      report_(index, real_part * real_part + imaginary_part * imaginary_part, i);
+    }
+
+    void report_(size_t index, double norm, size_t i)
+    {
+      // Escaped past the limit of this call, or not escaped yet.
+      i = std::min(i, max_iterations);
+      iterations[index] = static_cast<Count>(i);
+      if (smooth)
+      {
+        smooth[index] = smooth_iterations(i, norm, max_iterations);
+      }
+    }
+  };
+
+  template <typename Count>
+  struct Distance_operation_
+  {
+    const double* real;
+    size_t width;
+    const double* imaginary;
+    size_t height;
+    const std::complex<double>* k;
+    size_t max_iterations;
+    Count* iterations;
+    float* distance;
+    size_t stride;
+    const std::atomic<bool>& cancel_token;
+    uint64_t active_lane_iterations{0};
+    uint64_t lane_iterations{0};
+
+    void run_portable()
+    {
+      // dz/dc picks up one per iteration, dz/dz0 doesn't.
+      const auto one = k ? 0.0 : 1.0;
+      for (size_t y = 0; y < height; ++y)
+      {
+        if (cancel_token.load(std::memory_order_relaxed))
+        {
+          return;
+        }
+
+        for (size_t x = 0; x < width; ++x)
+        {
+          auto z = std::complex<double>{real[x], imaginary[y]};
+          auto c = k ? *k : z;
+          auto derivative = std::complex<double>{1.0, 0.0};
+          auto escape = max_iterations;
+          auto norm = 0.0;
+          auto derivative_norm = 0.0;
+          auto i = size_t{0};
+          for (; i < max_iterations; ++i)
+          {
+            norm = z.real() * z.real() + z.imag() * z.imag();
+            derivative_norm = std::norm(derivative);
+            if (escape == max_iterations && norm > 4)
+            {
+              escape = i;
+            }
+            if (norm > s_distance_radius_squared)
+            {
+              break;
+            }
+
+            auto derivative_real = z.real() * derivative.real() - z.imag() * derivative.imag();
+            auto derivative_imaginary = z.real() * derivative.imag() + z.imag() * derivative.real();
+            derivative = std::complex<double>{(derivative_real + derivative_real) + one, derivative_imaginary + derivative_imaginary};
+            z = std::complex<double>{(z.real() * z.real() - z.imag() * z.imag()) + c.real(),
+                                     (z.real() * z.imag() + z.real() * z.imag()) + c.imag()};
+
+            if (i % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+            {
+              break;
+            }
+          }
+
+          auto index = x + y * stride;
+          iterations[index] = static_cast<Count>(escape);
+          distance[index] = distance_estimate(escape, norm, derivative_norm, max_iterations);
+          active_lane_iterations += i;
+          lane_iterations += i;
+        }
+      }
+    }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    template <size_t Bytes>
+    __attribute__((always_inline)) inline void run()
+    {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+      using Vector = typename Lanes_<double, Bytes>::Vector;
+      using Mask = typename Lanes_<double, Bytes>::Mask;
+      constexpr auto lanes = Lanes_<double, Bytes>::count;
+
+      const auto four = Vector{} + 4;
+      const auto radius_squared = Vector{} + s_distance_radius_squared;
+      const auto one = Vector{} + (k ? 0.0 : 1.0);
+      const auto limit = Mask{} + static_cast<typename Lanes_<double, Bytes>::Integer>(max_iterations);
+      for (size_t y = 0; y < height; ++y)
+      {
+        for (size_t n = 0; n < width; n += lanes)
+        {
+          auto z_real = Vector{};
+          auto z_imaginary = Vector{} + imaginary[y];
+          for (size_t lane = 0; lane < lanes; ++lane)
+          {
+            // The last group is padded by repeating its final pixel.
+            z_real[lane] = real[std::min(n + lane, width - 1)];
+          }
+          auto c_real = k ? Vector{} + k->real() : z_real;
+          auto c_imaginary = k ? Vector{} + k->imag() : z_imaginary;
+          auto derivative_real = Vector{} + 1;
+          auto derivative_imaginary = Vector{};
+
+          auto escape = Mask{};
+          auto active = escape == escape;
+          // Lanes keep following z past the escape radius, their count is frozen but z and dz aren't yet.
+          auto tracking = active;
+          auto escape_norm = Vector{};
+          auto derivative_norm = Vector{};
+          for (size_t i = 0; i < max_iterations && any_<Bytes>(tracking); i += s_block_iterations)
+          {
+            // Past max_iterations nothing is tracked any more, as run_portable stops there.
+            const auto tracked = max_iterations - i < s_block_iterations ? max_iterations - i : s_block_iterations;
+            for (size_t block = 0; block < s_block_iterations; ++block)
+            {
+              if (block == tracked)
+              {
+                tracking = Mask{};
+              }
+
+              auto real_squared = z_real * z_real;
+              auto imaginary_squared = z_imaginary * z_imaginary;
+              auto norm = real_squared + imaginary_squared;
+              active &= (norm <= four);
+              escape -= active;
+
+              // Frozen at the first z past the distance radius.
+              escape_norm = tracking ? norm : escape_norm;
+              derivative_norm = tracking ? derivative_real * derivative_real + derivative_imaginary * derivative_imaginary : derivative_norm;
+              tracking &= (norm <= radius_squared);
+
+              auto next_derivative_real = (z_real * derivative_real - z_imaginary * derivative_imaginary);
+              next_derivative_real = (next_derivative_real + next_derivative_real) + one;
+              auto next_derivative_imaginary = (z_real * derivative_imaginary + z_imaginary * derivative_real);
+              derivative_imaginary = next_derivative_imaginary + next_derivative_imaginary;
+              derivative_real = next_derivative_real;
+
+              z_imaginary = (z_real * z_imaginary + z_real * z_imaginary) + c_imaginary;
+              z_real = (real_squared - imaginary_squared) + c_real;
+            }
+            lane_iterations += lanes * s_block_iterations;
+
+            if ((i / s_block_iterations) % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+            {
+              return;
+            }
+          }
+
+          // The last block can overshoot max_iterations.
+          escape = escape < limit ? escape : limit;
+
+          for (size_t lane = 0; lane < lanes && n + lane < width; ++lane)
+          {
+            auto index = n + lane + y * stride;
+            iterations[index] = static_cast<Count>(escape[lane]);
+            distance[index] = distance_estimate(static_cast<size_t>(escape[lane]), escape_norm[lane], derivative_norm[lane], max_iterations);
+            active_lane_iterations += static_cast<size_t>(escape[lane]);
+          }
+        }
+      }
+    }
+#endif
+  };
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  // Brent style cycle detection: z is compared against a saved point that is refreshed whenever the iteration count
+  // reaches the next power of two.  Lanes that come back within the tolerance are in a cycle and will never escape.
+  template <typename Vector, typename Mask>
+  __attribute__((always_inline)) static inline void check_periodicity_(const Vector& z_real,
+                                                                       const Vector& z_imaginary,
+                                                                       Vector& saved_real,
+                                                                       Vector& saved_imaginary,
+                                                                       Mask& checkpoint,
+                                                                       const Mask& escape,
+                                                                       Mask& active,
+                                                                       Mask& periodic,
+                                                                       const Vector& tolerance_squared)
+  {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    auto real_distance = z_real - saved_real;
+    auto imaginary_distance = z_imaginary - saved_imaginary;
+    auto cycle = active & (real_distance * real_distance + imaginary_distance * imaginary_distance < tolerance_squared);
+    periodic |= cycle;
+    active &= ~cycle;
+
+    auto save = escape == checkpoint;
+    saved_real = save ? z_real : saved_real;
+    saved_imaginary = save ? z_imaginary : saved_imaginary;
+    checkpoint = save ? checkpoint + checkpoint : checkpoint;
+  }
+#endif
+
+private:
+  Instruction_set m_instruction_set{Instruction_set::portable};
+  bool m_skip_resolved{false};
+  double m_periodicity_tolerance{0.0};
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+}
+
+#endif /* escape_time_kernel_h */
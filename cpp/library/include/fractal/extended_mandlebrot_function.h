@@ -0,0 +1,154 @@
+//
+//  extended_mandlebrot_function.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef extended_mandlebrot_function_h
+#define extended_mandlebrot_function_h
+
+#include <atomic>
+#include <complex>
+#include <memory>
+
+#include "colormap.h"
+#include "escape_time_kernel.h"
+#include "extended_precision.h"
+#include "symmetry.h"
+
+namespace Fractal
+{
+
+// Mandlebrot_function for views too deep for doubles but shallow enough that a reference orbit isn't worth it
+// (Perturbation_function), roughly scales of 1e-14 to 1e-30.  Every pixel is iterated in Number, Double_double or
+// Quad_double, so the cost per iteration is fixed and branch free.  Distributed_generator hands invoke_tile
+// coordinate tables of type Coordinate built from the extended view of the Fractal_view.
+template <typename Number>
+class Extended_mandlebrot_function final
+{
+public:
+  using Coordinate = Number;
+
+  Extended_mandlebrot_function() = default;
+  Extended_mandlebrot_function(size_t max_iterations)
+  : m_max_iterations{max_iterations}
+  {
+  }
+  Extended_mandlebrot_function(const Extended_mandlebrot_function&) = default;
+  Extended_mandlebrot_function(Extended_mandlebrot_function&&) = default;
+  ~Extended_mandlebrot_function() = default;
+
+  Extended_mandlebrot_function& operator=(const Extended_mandlebrot_function&) = default;
+  Extended_mandlebrot_function& operator=(Extended_mandlebrot_function&&) = default;
+
+  uint32_t invoke(const Number& real, const Number& imaginary, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    auto iterations = uint32_t{0};
+    Escape_time_kernel{}.invoke_extended(&real, imaginary, 1, m_max_iterations, &iterations, *cancel_token);
+    return (*m_color_table)(iterations);
+  }
+
+  uint32_t operator()(const Number& real, const Number& imaginary, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    return invoke(real, imaginary, cancel_token);
+  }
+
+  // Evaluates a width x height tile, pixel (x, y) being real[x] + imaginary[y] * i and landing in argb[x + y * stride].
+  void invoke_tile(const Number* real,
+                   size_t width,
+                   const Number* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    iterate_tile(real, width, imaginary, height, argb, nullptr, stride, cancel_token);
+    m_color_table->invoke_tile(argb, nullptr, width, height, stride, argb, stride);
+  }
+
+  // Escape counts of a width x height tile, pixel (x, y) landing in iterations[x + y * stride].  The extended
+  // kernel doesn't track the escape norm, smooth counts when requested are the whole counts.
+  template <typename Count>
+  void iterate_tile(const Number* real,
+                    size_t width,
+                    const Number* imaginary,
+                    size_t height,
+                    Count* iterations,
+                    float* smooth,
+                    size_t stride,
+                    const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    auto kernel = Escape_time_kernel{};
+    for (size_t y = 0; y < height; ++y)
+    {
+      auto row = iterations + y * stride;
+      kernel.invoke_extended(real, imaginary[y], width, m_max_iterations, row, *cancel_token, m_lane_statistics.get());
+
+      for (size_t x = 0; smooth && x < width; ++x)
+      {
+        smooth[x + y * stride] = static_cast<float>(row[x]);
+      }
+
+      if (cancel_token->load())
+      {
+        return;
+      }
+    }
+  }
+
+  Symmetry symmetry() const
+  {
+    return Symmetry::real_axis;
+  }
+
+  size_t max_iterations() const
+  {
+    return m_max_iterations;
+  }
+
+  void set_max_iterations(size_t iterations)
+  {
+    m_max_iterations = iterations;
+    m_color_table = std::make_shared<const Color_table>(m_color_table->colormap(), m_max_iterations);
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_color_table->colormap();
+  }
+
+  void set_colormap(Colormap colormap)
+  {
+    m_color_table = std::make_shared<const Color_table>(std::move(colormap), m_max_iterations);
+  }
+
+  // Colors escape counts, shared by the copies of the function.
+  const std::shared_ptr<const Color_table>& color_table() const
+  {
+    return m_color_table;
+  }
+
+  const std::shared_ptr<Lane_statistics>& lane_statistics() const
+  {
+    return m_lane_statistics;
+  }
+
+  void set_lane_statistics(std::shared_ptr<Lane_statistics> lane_statistics)
+  {
+    m_lane_statistics = std::move(lane_statistics);
+  }
+
+private:
+  size_t m_max_iterations{64};
+  std::shared_ptr<const Color_table> m_color_table{std::make_shared<const Color_table>(Colormap{}, m_max_iterations)};
+  std::shared_ptr<Lane_statistics> m_lane_statistics;
+};
+
+using Double_double_mandlebrot_function = Extended_mandlebrot_function<Double_double>;
+using Quad_double_mandlebrot_function = Extended_mandlebrot_function<Quad_double>;
+
+}
+
+#endif /* extended_mandlebrot_function_h */
@@ -0,0 +1,536 @@
+//
+//  extended_precision.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef extended_precision_h
+#define extended_precision_h
+
+#include <cstddef>
+#include <string>
+
+#include "fixed_point.h"
+
+// The arithmetic has to stay inlined into the ISA specific kernels (see Escape_time_kernel), or the vector arguments
+// would cross a function call compiled for the baseline target.
+#if defined(__GNUC__)
+#define FRACTAL_EXTENDED_INLINE __attribute__((always_inline)) inline
+#else
+#define FRACTAL_EXTENDED_INLINE inline
+#endif
+
+// The error free transformations below are only exact when the compiler doesn't fuse their multiplies and adds.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace Fractal
+{
+
+// Building blocks of double-double and quad-double arithmetic (Dekker, Knuth, Hida, Li and Bailey).  Written with
+// plain operators only so that Real can be a double or a GCC/Clang vector of doubles, which keeps the kernels branch
+// free and lets them run one pixel per lane.
+struct Error_free_transforms final
+{
+  // Outputs may alias the inputs.
+  template <typename Real>
+  static FRACTAL_EXTENDED_INLINE void two_sum(const Real& a, const Real& b, Real& sum, Real& error)
+  {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    auto s = a + b;
+    auto b_virtual = s - a;
+    auto e = (a - (s - b_virtual)) + (b - b_virtual);
+    sum = s;
+    error = e;
+  }
+
+  // Requires |a| >= |b|.
+  template <typename Real>
+  static FRACTAL_EXTENDED_INLINE void quick_two_sum(const Real& a, const Real& b, Real& sum, Real& error)
+  {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    auto s = a + b;
+    auto e = b - (s - a);
+    sum = s;
+    error = e;
+  }
+
+  template <typename Real>
+  static FRACTAL_EXTENDED_INLINE void two_product(const Real& a, const Real& b, Real& product, Real& error)
+  {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    auto p = a * b;
+    auto a_high = Real{};
+    auto a_low = Real{};
+    auto b_high = Real{};
+    auto b_low = Real{};
+    split_(a, a_high, a_low);
+    split_(b, b_high, b_low);
+    auto high = a_high * b_high - p;
+    auto middle = high + a_high * b_low;
+    middle = middle + a_low * b_high;
+    error = middle + a_low * b_low;
+    product = p;
+  }
+
+  // a + b + c, leaving the result in a and the two error terms in b and c.
+  template <typename Real>
+  static FRACTAL_EXTENDED_INLINE void three_sum(Real& a, Real& b, Real& c)
+  {
+    auto sum = Real{};
+    auto error_2 = Real{};
+    auto error_3 = Real{};
+    two_sum(a, b, sum, error_2);
+    two_sum(c, sum, a, error_3);
+    two_sum(error_2, error_3, b, c);
+  }
+
+  // a + b + c, leaving the result in a and the error in b.
+  template <typename Real>
+  static FRACTAL_EXTENDED_INLINE void three_sum_2(Real& a, Real& b, const Real& c)
+  {
+    auto sum = Real{};
+    auto error_2 = Real{};
+    auto error_3 = Real{};
+    two_sum(a, b, sum, error_2);
+    two_sum(c, sum, a, error_3);
+    b = error_2 + error_3;
+  }
+
+private:
+  template <typename Real>
+  static FRACTAL_EXTENDED_INLINE void split_(const Real& a, Real& high, Real& low)
+  {
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+    // 2^27 + 1, splits the 53 bit significand in two halves whose products are exact.
+    auto t = a * 134217729.0;
+    high = t - (t - a);
+    low = a - high;
+  }
+};
+
+template <typename Real>
+class Basic_quad_double;
+
+// Unevaluated sum of two doubles, about 106 bits of significand.
+template <typename Real>
+class Basic_double_double final
+{
+public:
+  static constexpr size_t size = 2;
+
+  template <typename Other>
+  using rebind = Basic_double_double<Other>;
+
+  Basic_double_double() = default;
+  Basic_double_double(const Real& value)
+  : m_components{value, Real{}}
+  {
+  }
+  Basic_double_double(const Real& high, const Real& low)
+  : m_components{high, low}
+  {
+  }
+  explicit Basic_double_double(const Basic_quad_double<Real>& value)
+  : m_components{value[0], value[1]}
+  {
+  }
+  Basic_double_double(const Basic_double_double&) = default;
+  Basic_double_double(Basic_double_double&&) = default;
+  ~Basic_double_double() = default;
+
+  Basic_double_double& operator=(const Basic_double_double&) = default;
+  Basic_double_double& operator=(Basic_double_double&&) = default;
+
+  // Parses a decimal string to the full precision of the type.
+  static Basic_double_double parse(const std::string& value)
+  {
+    auto result = Basic_double_double{};
+    auto remainder = Fixed_point{value, s_parse_bits};
+    for (size_t i = 0; i < size; ++i)
+    {
+      result.m_components[i] = remainder.to_double();
+      remainder -= Fixed_point{result.m_components[i], s_parse_bits};
+    }
+    return result;
+  }
+
+  FRACTAL_EXTENDED_INLINE Real& operator[](size_t i)
+  {
+    return m_components[i];
+  }
+
+  FRACTAL_EXTENDED_INLINE const Real& operator[](size_t i) const
+  {
+    return m_components[i];
+  }
+
+  Real to_double() const
+  {
+    return m_components[0] + m_components[1];
+  }
+
+  FRACTAL_EXTENDED_INLINE Basic_double_double operator-() const
+  {
+    return Basic_double_double{-m_components[0], -m_components[1]};
+  }
+
+  friend FRACTAL_EXTENDED_INLINE Basic_double_double operator+(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    auto s = Real{};
+    auto s_error = Real{};
+    auto t = Real{};
+    auto t_error = Real{};
+    Error_free_transforms::two_sum(a[0], b[0], s, s_error);
+    Error_free_transforms::two_sum(a[1], b[1], t, t_error);
+    s_error = s_error + t;
+    Error_free_transforms::quick_two_sum(s, s_error, s, s_error);
+    s_error = s_error + t_error;
+    Error_free_transforms::quick_two_sum(s, s_error, s, s_error);
+    return Basic_double_double{s, s_error};
+  }
+
+  friend FRACTAL_EXTENDED_INLINE Basic_double_double operator-(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    return a + -b;
+  }
+
+  friend FRACTAL_EXTENDED_INLINE Basic_double_double operator*(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    auto product = Real{};
+    auto error = Real{};
+    Error_free_transforms::two_product(a[0], b[0], product, error);
+    error = error + (a[0] * b[1] + a[1] * b[0]);
+    Error_free_transforms::quick_two_sum(product, error, product, error);
+    return Basic_double_double{product, error};
+  }
+
+  friend Basic_double_double operator/(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    // Long division, each quotient digit is estimated from the leading components.
+    auto q_0 = a[0] / b[0];
+    auto remainder = a - b * Basic_double_double{q_0};
+    auto q_1 = remainder[0] / b[0];
+    remainder = remainder - b * Basic_double_double{q_1};
+    auto q_2 = remainder[0] / b[0];
+    return Basic_double_double{q_0} + Basic_double_double{q_1} + Basic_double_double{q_2};
+  }
+
+  Basic_double_double& operator+=(const Basic_double_double& other)
+  {
+    return *this = *this + other;
+  }
+
+  Basic_double_double& operator-=(const Basic_double_double& other)
+  {
+    return *this = *this - other;
+  }
+
+  Basic_double_double& operator*=(const Basic_double_double& other)
+  {
+    return *this = *this * other;
+  }
+
+  friend bool operator<(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    return a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]);
+  }
+
+  friend bool operator>(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    return b < a;
+  }
+
+  friend bool operator==(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    return a[0] == b[0] && a[1] == b[1];
+  }
+
+  friend bool operator!=(const Basic_double_double& a, const Basic_double_double& b)
+  {
+    return !(a == b);
+  }
+
+private:
+  static constexpr size_t s_parse_bits = 192;
+
+  Real m_components[size]{};
+};
+
+// Unevaluated sum of four doubles, about 212 bits of significand.  Additions and multiplications follow the fast
+// ("sloppy") variants of the QD library with a branch free renormalization.
+template <typename Real>
+class Basic_quad_double final
+{
+public:
+  static constexpr size_t size = 4;
+
+  template <typename Other>
+  using rebind = Basic_quad_double<Other>;
+
+  Basic_quad_double() = default;
+  Basic_quad_double(const Real& value)
+  : m_components{value, Real{}, Real{}, Real{}}
+  {
+  }
+  Basic_quad_double(const Real& x_0, const Real& x_1, const Real& x_2, const Real& x_3)
+  : m_components{x_0, x_1, x_2, x_3}
+  {
+  }
+  explicit Basic_quad_double(const Basic_double_double<Real>& value)
+  : m_components{value[0], value[1], Real{}, Real{}}
+  {
+  }
+  Basic_quad_double(const Basic_quad_double&) = default;
+  Basic_quad_double(Basic_quad_double&&) = default;
+  ~Basic_quad_double() = default;
+
+  Basic_quad_double& operator=(const Basic_quad_double&) = default;
+  Basic_quad_double& operator=(Basic_quad_double&&) = default;
+
+  // Parses a decimal string to the full precision of the type.
+  static Basic_quad_double parse(const std::string& value)
+  {
+    auto result = Basic_quad_double{};
+    auto remainder = Fixed_point{value, s_parse_bits};
+    for (size_t i = 0; i < size; ++i)
+    {
+      result.m_components[i] = remainder.to_double();
+      remainder -= Fixed_point{result.m_components[i], s_parse_bits};
+    }
+    return result;
+  }
+
+  FRACTAL_EXTENDED_INLINE Real& operator[](size_t i)
+  {
+    return m_components[i];
+  }
+
+  FRACTAL_EXTENDED_INLINE const Real& operator[](size_t i) const
+  {
+    return m_components[i];
+  }
+
+  Real to_double() const
+  {
+    return m_components[0] + (m_components[1] + (m_components[2] + m_components[3]));
+  }
+
+  FRACTAL_EXTENDED_INLINE Basic_quad_double operator-() const
+  {
+    return Basic_quad_double{-m_components[0], -m_components[1], -m_components[2], -m_components[3]};
+  }
+
+  friend FRACTAL_EXTENDED_INLINE Basic_quad_double operator+(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    auto s_0 = Real{};
+    auto s_1 = Real{};
+    auto s_2 = Real{};
+    auto s_3 = Real{};
+    auto t_0 = Real{};
+    auto t_1 = Real{};
+    auto t_2 = Real{};
+    auto t_3 = Real{};
+    Error_free_transforms::two_sum(a[0], b[0], s_0, t_0);
+    Error_free_transforms::two_sum(a[1], b[1], s_1, t_1);
+    Error_free_transforms::two_sum(a[2], b[2], s_2, t_2);
+    Error_free_transforms::two_sum(a[3], b[3], s_3, t_3);
+
+    Error_free_transforms::two_sum(s_1, t_0, s_1, t_0);
+    Error_free_transforms::three_sum(s_2, t_0, t_1);
+    Error_free_transforms::three_sum_2(s_3, t_0, t_2);
+    t_0 = t_0 + t_1 + t_3;
+    return renormalize_(s_0, s_1, s_2, s_3, t_0);
+  }
+
+  friend FRACTAL_EXTENDED_INLINE Basic_quad_double operator-(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    return a + -b;
+  }
+
+  friend FRACTAL_EXTENDED_INLINE Basic_quad_double operator*(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    auto p_0 = Real{};
+    auto p_1 = Real{};
+    auto p_2 = Real{};
+    auto p_3 = Real{};
+    auto p_4 = Real{};
+    auto p_5 = Real{};
+    auto q_0 = Real{};
+    auto q_1 = Real{};
+    auto q_2 = Real{};
+    auto q_3 = Real{};
+    auto q_4 = Real{};
+    auto q_5 = Real{};
+    Error_free_transforms::two_product(a[0], b[0], p_0, q_0);
+    Error_free_transforms::two_product(a[0], b[1], p_1, q_1);
+    Error_free_transforms::two_product(a[1], b[0], p_2, q_2);
+    Error_free_transforms::two_product(a[0], b[2], p_3, q_3);
+    Error_free_transforms::two_product(a[1], b[1], p_4, q_4);
+    Error_free_transforms::two_product(a[2], b[0], p_5, q_5);
+
+    // Terms of order epsilon.
+    Error_free_transforms::three_sum(p_1, p_2, q_0);
+
+    // Terms of order epsilon^2.
+    Error_free_transforms::three_sum(p_2, q_1, q_2);
+    Error_free_transforms::three_sum(p_3, p_4, p_5);
+    auto s_0 = Real{};
+    auto s_1 = Real{};
+    auto t_0 = Real{};
+    auto t_1 = Real{};
+    Error_free_transforms::two_sum(p_2, p_3, s_0, t_0);
+    Error_free_transforms::two_sum(q_1, p_4, s_1, t_1);
+    auto s_2 = q_2 + p_5;
+    Error_free_transforms::two_sum(s_1, t_0, s_1, t_0);
+    s_2 = s_2 + (t_0 + t_1);
+
+    // Terms of order epsilon^3 only need plain arithmetic.
+    s_1 = s_1 + (a[0] * b[3] + a[1] * b[2] + a[2] * b[1] + a[3] * b[0] + q_0 + q_3 + q_4 + q_5);
+    return renormalize_(p_0, p_1, s_0, s_1, s_2);
+  }
+
+  friend Basic_quad_double operator/(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    // Long division, each quotient digit is estimated from the leading components.
+    auto result = Basic_quad_double{};
+    auto remainder = a;
+    for (size_t i = 0; i <= size; ++i)
+    {
+      auto q = remainder[0] / b[0];
+      remainder = remainder - b * Basic_quad_double{q};
+      result = result + Basic_quad_double{q};
+    }
+    return result;
+  }
+
+  Basic_quad_double& operator+=(const Basic_quad_double& other)
+  {
+    return *this = *this + other;
+  }
+
+  Basic_quad_double& operator-=(const Basic_quad_double& other)
+  {
+    return *this = *this - other;
+  }
+
+  Basic_quad_double& operator*=(const Basic_quad_double& other)
+  {
+    return *this = *this * other;
+  }
+
+  friend bool operator<(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    for (size_t i = 0; i < size; ++i)
+    {
+      if (a[i] != b[i])
+      {
+        return a[i] < b[i];
+      }
+    }
+    return false;
+  }
+
+  friend bool operator>(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    return b < a;
+  }
+
+  friend bool operator==(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+  }
+
+  friend bool operator!=(const Basic_quad_double& a, const Basic_quad_double& b)
+  {
+    return !(a == b);
+  }
+
+private:
+  static constexpr size_t s_parse_bits = 320;
+
+  // Turns the five overlapping terms of a sum or product back into four non overlapping components, a sweep from
+  // the bottom to propagate the carries followed by one from the top to spread the bits out.
+  static FRACTAL_EXTENDED_INLINE Basic_quad_double renormalize_(Real& c_0, Real& c_1, Real& c_2, Real& c_3, Real& c_4)
+  {
+    auto s = Real{};
+    Error_free_transforms::quick_two_sum(c_3, c_4, s, c_4);
+    Error_free_transforms::quick_two_sum(c_2, s, s, c_3);
+    Error_free_transforms::quick_two_sum(c_1, s, s, c_2);
+    Error_free_transforms::quick_two_sum(c_0, s, c_0, c_1);
+
+    Error_free_transforms::quick_two_sum(c_0, c_1, c_0, c_1);
+    Error_free_transforms::quick_two_sum(c_1, c_2, c_1, c_2);
+    Error_free_transforms::quick_two_sum(c_2, c_3, c_2, c_3);
+    c_3 = c_3 + c_4;
+    return Basic_quad_double{c_0, c_1, c_2, c_3};
+  }
+
+  Real m_components[size]{};
+};
+
+using Double_double = Basic_double_double<double>;
+using Quad_double = Basic_quad_double<double>;
+
+// Conversions between the coordinate types, used to narrow the extended view of a Fractal_view to what a function
+// iterates with.
+template <typename Number>
+struct Extended_precision_traits;
+
+template <>
+struct Extended_precision_traits<float>
+{
+  static float from(const Quad_double& value)
+  {
+    return static_cast<float>(value[0]);
+  }
+};
+
+template <>
+struct Extended_precision_traits<double>
+{
+  static double from(const Quad_double& value)
+  {
+    return value[0];
+  }
+};
+
+template <>
+struct Extended_precision_traits<Double_double>
+{
+  static Double_double from(const Quad_double& value)
+  {
+    return Double_double{value};
+  }
+};
+
+template <>
+struct Extended_precision_traits<Quad_double>
+{
+  static Quad_double from(const Quad_double& value)
+  {
+    return value;
+  }
+};
+
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+#undef FRACTAL_EXTENDED_INLINE
+
+#endif /* extended_precision_h */
@@ -0,0 +1,261 @@
+//
+//  fixed_point.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef fixed_point_h
+#define fixed_point_h
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Fractal
+{
+
+// Signed fixed point number with a runtime number of 32 bit limbs.  The most significant limb holds the integer part
+// and the others the fraction, in two's complement.  It only has to cover the handful of operations needed to iterate
+// a reference orbit, so the integer part is limited to 32 bits.
+class Fixed_point final
+{
+public:
+  Fixed_point() = default;
+  explicit Fixed_point(size_t precision_bits)
+  : m_limbs(limb_count_(precision_bits), 0)
+  {
+  }
+  Fixed_point(double value, size_t precision_bits)
+  : m_limbs(limb_count_(precision_bits), 0)
+  {
+    assign_(value);
+  }
+  // Parses a decimal number such as "-0.743643887037158704752191506114774" or "1.5e-3", to within the precision.
+  Fixed_point(const std::string& value, size_t precision_bits)
+  : m_limbs(limb_count_(precision_bits), 0)
+  {
+    parse_(value);
+  }
+  Fixed_point(const Fixed_point&) = default;
+  Fixed_point(Fixed_point&&) = default;
+  ~Fixed_point() = default;
+
+  Fixed_point& operator=(const Fixed_point&) = default;
+  Fixed_point& operator=(Fixed_point&&) = default;
+
+  size_t precision_bits() const
+  {
+    return (m_limbs.size() - 1) * 32;
+  }
+
+  bool negative() const
+  {
+    return !m_limbs.empty() && (m_limbs.back() & 0x80000000) != 0;
+  }
+
+  double to_double() const
+  {
+    auto magnitude = negative() ? -*this : *this;
+    auto value = 0.0;
+    for (size_t i = 0; i < magnitude.m_limbs.size(); ++i)
+    {
+      value += std::ldexp(static_cast<double>(magnitude.m_limbs[i]), 32 * (static_cast<int>(i) - static_cast<int>(fraction_limbs_())));
+    }
+    return negative() ? -value : value;
+  }
+
+  Fixed_point operator-() const
+  {
+    auto result = *this;
+    auto carry = uint64_t{1};
+    for (auto& limb : result.m_limbs)
+    {
+      carry += static_cast<uint32_t>(~limb);
+      limb = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    return result;
+  }
+
+  Fixed_point& operator+=(const Fixed_point& other)
+  {
+    auto carry = uint64_t{0};
+    for (size_t i = 0; i < m_limbs.size(); ++i)
+    {
+      carry += static_cast<uint64_t>(m_limbs[i]) + other.m_limbs[i];
+      m_limbs[i] = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    return *this;
+  }
+
+  Fixed_point& operator-=(const Fixed_point& other)
+  {
+    return *this += -other;
+  }
+
+  Fixed_point& operator*=(const Fixed_point& other)
+  {
+    auto negative_result = negative() != other.negative();
+    auto left = negative() ? -*this : *this;
+    auto right = other.negative() ? -other : other;
+
+    // Schoolbook product of the magnitudes, keeping the limbs that line up with the fixed point.
+    auto count = m_limbs.size();
+    auto product = std::vector<uint32_t>(2 * count, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto carry = uint64_t{0};
+      for (size_t j = 0; j < count; ++j)
+      {
+        carry += static_cast<uint64_t>(left.m_limbs[i]) * right.m_limbs[j] + product[i + j];
+        product[i + j] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+      }
+      product[i + count] = static_cast<uint32_t>(carry);
+    }
+
+    std::copy(product.begin() + fraction_limbs_(), product.begin() + fraction_limbs_() + count, m_limbs.begin());
+    if (negative_result)
+    {
+      *this = -*this;
+    }
+    return *this;
+  }
+
+  friend Fixed_point operator+(Fixed_point left, const Fixed_point& right)
+  {
+    return left += right;
+  }
+
+  friend Fixed_point operator-(Fixed_point left, const Fixed_point& right)
+  {
+    return left -= right;
+  }
+
+  friend Fixed_point operator*(Fixed_point left, const Fixed_point& right)
+  {
+    return left *= right;
+  }
+
+private:
+  static size_t limb_count_(size_t precision_bits)
+  {
+    return 1 + (precision_bits + 31) / 32;
+  }
+
+  size_t fraction_limbs_() const
+  {
+    return m_limbs.size() - 1;
+  }
+
+  void assign_(double value)
+  {
+    // Every step is exact, a double always fits in the fraction limbs it needs.
+    auto magnitude = std::fabs(value);
+    auto integer = std::floor(magnitude);
+    m_limbs.back() = static_cast<uint32_t>(integer);
+    magnitude -= integer;
+    for (size_t i = fraction_limbs_(); i-- > 0 && magnitude > 0;)
+    {
+      magnitude = std::ldexp(magnitude, 32);
+      auto limb = std::floor(magnitude);
+      m_limbs[i] = static_cast<uint32_t>(limb);
+      magnitude -= limb;
+    }
+
+    if (value < 0)
+    {
+      *this = -*this;
+    }
+  }
+
+  void parse_(const std::string& value)
+  {
+    auto position = size_t{0};
+    auto negative_value = false;
+    if (position < value.size() && (value[position] == '-' || value[position] == '+'))
+    {
+      negative_value = value[position] == '-';
+      ++position;
+    }
+
+    auto integer = uint32_t{0};
+    for (; position < value.size() && std::isdigit(static_cast<unsigned char>(value[position])); ++position)
+    {
+      integer = integer * 10 + static_cast<uint32_t>(value[position] - '0');
+    }
+
+    auto fraction = std::string{};
+    if (position < value.size() && value[position] == '.')
+    {
+      for (++position; position < value.size() && std::isdigit(static_cast<unsigned char>(value[position])); ++position)
+      {
+        fraction.push_back(value[position]);
+      }
+    }
+
+    auto exponent = 0L;
+    if (position < value.size() && (value[position] == 'e' || value[position] == 'E'))
+    {
+      exponent = std::stol(value.substr(position + 1));
+    }
+
+    // Horner's scheme from the last digit up, dividing by ten each step.
+    for (auto digit = fraction.rbegin(); digit != fraction.rend(); ++digit)
+    {
+      m_limbs.back() += static_cast<uint32_t>(*digit - '0');
+      divide_(10);
+    }
+    m_limbs.back() += integer;
+
+    for (; exponent < 0; ++exponent)
+    {
+      divide_(10);
+    }
+    for (; exponent > 0; --exponent)
+    {
+      multiply_(10);
+    }
+
+    if (negative_value)
+    {
+      *this = -*this;
+    }
+  }
+
+  // Only used on non negative values while parsing.
+  void divide_(uint32_t divisor)
+  {
+    auto remainder = uint64_t{0};
+    for (size_t i = m_limbs.size(); i-- > 0;)
+    {
+      auto dividend = (remainder << 32) | m_limbs[i];
+      m_limbs[i] = static_cast<uint32_t>(dividend / divisor);
+      remainder = dividend % divisor;
+    }
+  }
+
+  void multiply_(uint32_t factor)
+  {
+    auto carry = uint64_t{0};
+    for (auto& limb : m_limbs)
+    {
+      carry += static_cast<uint64_t>(limb) * factor;
+      limb = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+  }
+
+private:
+  std::vector<uint32_t> m_limbs;
+};
+
+}
+
+#endif /* fixed_point_h */
@@ -0,0 +1,187 @@
+//
+//  formula.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef formula_h
+#define formula_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "symmetry.h"
+
+// Policies are instantiated with a scalar Real for the portable path and with the vector types of
+// Escape_time_kernel for the SIMD paths, so they must stay free of branches on their arguments.
+#define FRACTAL_POLICY_INLINE __attribute__((always_inline)) inline
+
+namespace Fractal
+{
+
+// Formulas of z(n + 1) = f(z(n), c).  start sets the constant from the pixel and the constant given to the kernel,
+// every formula starts iterating at z(0) = pixel.  power is the growth rate of |z| once it escapes, used by the smooth
+// coloring, and symmetry that of the image the formula renders.
+
+// z = z^2 + c with c the pixel.
+struct Mandlebrot_formula
+{
+  static constexpr size_t power = 2;
+  static constexpr Symmetry symmetry = Symmetry::real_axis;
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void start(const T& real, const T& imaginary, const T&, const T&, T& c_real, T& c_imaginary)
+  {
+    c_real = real;
+    c_imaginary = imaginary;
+  }
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void step(T& z_real, T& z_imaginary, const T& c_real, const T& c_imaginary)
+  {
+    auto real_squared = z_real * z_real;
+    auto imaginary_squared = z_imaginary * z_imaginary;
+    z_imaginary = (z_real * z_imaginary + z_real * z_imaginary) + c_imaginary;
+    z_real = (real_squared - imaginary_squared) + c_real;
+  }
+};
+
+// z = z^2 + k with k the constant of the kernel.
+struct Julia_formula
+{
+  static constexpr size_t power = 2;
+  static constexpr Symmetry symmetry = Symmetry::origin;
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void start(const T&, const T&, const T& k_real, const T& k_imaginary, T& c_real, T& c_imaginary)
+  {
+    c_real = k_real;
+    c_imaginary = k_imaginary;
+  }
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void step(T& z_real, T& z_imaginary, const T& c_real, const T& c_imaginary)
+  {
+    Mandlebrot_formula::step(z_real, z_imaginary, c_real, c_imaginary);
+  }
+};
+
+// z = z^Power + c, the power is unrolled into Power - 1 complex multiplications.
+template <size_t Power>
+struct Multibrot_formula
+{
+  static_assert(Power >= 2, "Multibrot power must be at least 2");
+
+  static constexpr size_t power = Power;
+  static constexpr Symmetry symmetry = Symmetry::real_axis;
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void start(const T& real, const T& imaginary, const T&, const T&, T& c_real, T& c_imaginary)
+  {
+    c_real = real;
+    c_imaginary = imaginary;
+  }
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void step(T& z_real, T& z_imaginary, const T& c_real, const T& c_imaginary)
+  {
+    auto real = z_real;
+    auto imaginary = z_imaginary;
+    for (size_t n = 1; n < Power; ++n)
+    {
+      auto product_real = real * z_real - imaginary * z_imaginary;
+      imaginary = real * z_imaginary + imaginary * z_real;
+      real = product_real;
+    }
+    z_real = real + c_real;
+    z_imaginary = imaginary + c_imaginary;
+  }
+};
+
+// z = (|Re z| + |Im z| i)^2 + c.
+struct Burning_ship_formula
+{
+  static constexpr size_t power = 2;
+  static constexpr Symmetry symmetry = Symmetry::none;
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void start(const T& real, const T& imaginary, const T&, const T&, T& c_real, T& c_imaginary)
+  {
+    c_real = real;
+    c_imaginary = imaginary;
+  }
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE void step(T& z_real, T& z_imaginary, const T& c_real, const T& c_imaginary)
+  {
+    z_real = z_real < T{} ? -z_real : z_real;
+    z_imaginary = z_imaginary < T{} ? -z_imaginary : z_imaginary;
+    Mandlebrot_formula::step(z_real, z_imaginary, c_real, c_imaginary);
+  }
+};
+
+// Escape tests, bounded is true (all ones in a vector) while z hasn't escaped.
+
+// |z| <= Radius.
+template <size_t Radius>
+struct Circle_escape
+{
+  static constexpr size_t radius = Radius;
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE auto bounded(const T& z_real, const T& z_imaginary) -> decltype(z_real <= z_real)
+  {
+    return z_real * z_real + z_imaginary * z_imaginary <= T{} + static_cast<int>(Radius * Radius);
+  }
+};
+
+// max(|Re z|, |Im z|) <= Radius, cheaper than the circle and escaping at most one iteration later.
+template <size_t Radius>
+struct Square_escape
+{
+  static constexpr size_t radius = Radius;
+
+  template <typename T>
+  static FRACTAL_POLICY_INLINE auto bounded(const T& z_real, const T& z_imaginary) -> decltype(z_real <= z_real)
+  {
+    const auto limit = T{} + static_cast<int>(Radius);
+    return (z_real <= limit) & (-z_real <= limit) & (z_imaginary <= limit) & (-z_imaginary <= limit);
+  }
+};
+
+// Colorings, what the kernel writes for each pixel on top of its escape count.
+
+// Whole escape counts only.
+struct Count_coloring
+{
+  static constexpr bool smooth = false;
+};
+
+// Fractional escape counts from |z|^2 when the pixel escaped, which removes the banding between counts.
+struct Smooth_coloring
+{
+  static constexpr bool smooth = true;
+
+  template <typename Formula, typename Escape>
+  static float smooth_iterations(size_t iterations, double norm, size_t max_iterations)
+  {
+    const auto radius = static_cast<double>(Escape::radius);
+    if (iterations >= max_iterations || !(norm > radius * radius))
+    {
+      return static_cast<float>(std::min(iterations, max_iterations));
+    }
+
+    auto smooth = static_cast<double>(iterations) + 1.0
+                - std::log(0.5 * std::log(norm) / std::log(radius)) / std::log(static_cast<double>(Formula::power));
+    return static_cast<float>(std::max(smooth, 0.0));
+  }
+};
+
+}
+
+#undef FRACTAL_POLICY_INLINE
+
+#endif /* formula_h */
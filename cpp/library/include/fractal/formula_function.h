@@ -0,0 +1,198 @@
+//
+//  formula_function.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef formula_function_h
+#define formula_function_h
+
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+
+#include "colormap.h"
+#include "escape_time_kernel.h"
+#include "formula.h"
+
+namespace Fractal
+{
+
+// Escape time function assembled from policies (see formula.h): the formula iterated, the escape test, the coloring
+// and how many iterations pass between two checks of the cancel token.  Each combination is its own specialized tile
+// loop in Escape_time_kernel::invoke_formula, so supporting another formula is a matter of writing its policy.
+// Mandlebrot_function and Julia_function remain the functions of choice for those two sets, they add the interior
+// test, periodicity checking and lane streaming on top of the same iteration.
+template <typename Formula,
+          typename Escape = Circle_escape<2>,
+          typename Coloring = Count_coloring,
+          size_t Cancel_check_interval = 2048>
+class Formula_function final
+{
+public:
+  Formula_function() = default;
+  Formula_function(size_t max_iterations)
+  : m_max_iterations{max_iterations}
+  {
+  }
+  // constant is the k of Julia_formula, other formulas ignore it.
+  Formula_function(std::complex<double> constant, size_t max_iterations)
+  : m_constant{std::move(constant)},
+    m_max_iterations{max_iterations}
+  {
+  }
+  Formula_function(const Formula_function&) = default;
+  Formula_function(Formula_function&&) = default;
+  ~Formula_function() = default;
+
+  Formula_function& operator=(const Formula_function&) = default;
+  Formula_function& operator=(Formula_function&&) = default;
+
+  uint32_t invoke(std::complex<double> z, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    auto real = z.real();
+    auto imaginary = z.imag();
+    auto iterations = uint32_t{0};
+    auto smooth = float{0};
+    kernel_().template invoke_formula<Formula, Escape, Coloring, Cancel_check_interval>(&real,
+                                                                                      1,
+                                                                                      &imaginary,
+                                                                                      1,
+                                                                                      m_constant,
+                                                                                      m_max_iterations,
+                                                                                      &iterations,
+                                                                                      &smooth,
+                                                                                      1,
+                                                                                      *cancel_token);
+    return Coloring::smooth ? m_color_table->invoke_smooth(smooth) : (*m_color_table)(iterations);
+  }
+
+  uint32_t operator()(std::complex<double> z, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    return invoke(std::move(z), cancel_token);
+  }
+
+  // Evaluates a width x height tile, pixel (x, y) being real[x] + imaginary[y] * i and landing in argb[x + y * stride].
+  void invoke_tile(const double* real,
+                   size_t width,
+                   const double* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    if (Coloring::smooth)
+    {
+      auto iterations = std::vector<uint32_t>(width * height);
+      auto smooth = std::vector<float>(width * height);
+      iterate_tile(real, width, imaginary, height, iterations.data(), smooth.data(), width, cancel_token);
+      m_color_table->invoke_tile(iterations.data(), smooth.data(), width, height, width, argb, stride);
+      return;
+    }
+
+    // The tile doubles as the iteration buffer, each count is replaced by its color in place.
+    iterate_tile(real, width, imaginary, height, argb, nullptr, stride, cancel_token);
+    m_color_table->invoke_tile(argb, nullptr, width, height, stride, argb, stride);
+  }
+
+  // Escape counts of a width x height tile, pixel (x, y) landing in iterations[x + y * stride] and, with
+  // Smooth_coloring and smooth not null, its fractional count in smooth[x + y * stride].
+  template <typename Real, typename Count>
+  void iterate_tile(const Real* real,
+                    size_t width,
+                    const Real* imaginary,
+                    size_t height,
+                    Count* iterations,
+                    float* smooth,
+                    size_t stride,
+                    const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    kernel_().template invoke_formula<Formula, Escape, Coloring, Cancel_check_interval>(real,
+                                                                                      width,
+                                                                                      imaginary,
+                                                                                      height,
+                                                                                      std::complex<Real>{m_constant},
+                                                                                      m_max_iterations,
+                                                                                      iterations,
+                                                                                      smooth,
+                                                                                      stride,
+                                                                                      *cancel_token,
+                                                                                      m_lane_statistics.get());
+  }
+
+  Symmetry symmetry() const
+  {
+    return Formula::symmetry;
+  }
+
+  size_t max_iterations() const
+  {
+    return m_max_iterations;
+  }
+
+  void set_max_iterations(size_t iterations)
+  {
+    m_max_iterations = iterations;
+    m_color_table = std::make_shared<const Color_table>(m_color_table->colormap(), m_max_iterations);
+  }
+
+  std::complex<double> constant() const
+  {
+    return m_constant;
+  }
+
+  void set_constant(std::complex<double> constant)
+  {
+    m_constant = std::move(constant);
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_color_table->colormap();
+  }
+
+  void set_colormap(Colormap colormap)
+  {
+    m_color_table = std::make_shared<const Color_table>(std::move(colormap), m_max_iterations);
+  }
+
+  // Colors escape counts, shared by the copies of the function.
+  const std::shared_ptr<const Color_table>& color_table() const
+  {
+    return m_color_table;
+  }
+
+  const std::shared_ptr<Lane_statistics>& lane_statistics() const
+  {
+    return m_lane_statistics;
+  }
+
+  // Copies of the function share the statistics, so one instance can collect the lane utilization of a whole render.
+  void set_lane_statistics(std::shared_ptr<Lane_statistics> lane_statistics)
+  {
+    m_lane_statistics = std::move(lane_statistics);
+  }
+
+private:
+  Escape_time_kernel kernel_() const
+  {
+    return Escape_time_kernel{};
+  }
+
+private:
+  std::complex<double> m_constant;
+  size_t m_max_iterations{64};
+  std::shared_ptr<const Color_table> m_color_table{std::make_shared<const Color_table>(Colormap{}, m_max_iterations)};
+  std::shared_ptr<Lane_statistics> m_lane_statistics;
+};
+
+template <size_t Power>
+using Multibrot_function = Formula_function<Multibrot_formula<Power>>;
+using Burning_ship_function = Formula_function<Burning_ship_formula>;
+
+}
+
+#endif /* formula_function_h */
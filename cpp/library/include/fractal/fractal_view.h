@@ -9,33 +9,192 @@
 #ifndef fractal_view_h
 #define fractal_view_h
 
+#include <algorithm>
 #include <complex>
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <vector>
 
+#include "extended_precision.h"
+#include "framebuffer_pool.h"
+#include "iteration_buffer.h"
+#include "iteration_state.h"
 #include "messages.h"
 
 namespace Fractal
 {
 
+// Where each pixel of a view is in its buffer.  Linear is row after row across the whole view.  Blocked cuts the
+// view into blocks of block_width x block_height pixels, each contiguous, row after row within the block, the blocks
+// themselves going row after row across the view, those on the right and bottom edges padded out to a whole block.
+// A tile that is a block is then one run of memory a worker fills without touching its neighbours' cache lines, and
+// that goes out as it is.
+class Pixel_layout final
+{
+public:
+  Pixel_layout() = default;
+  Pixel_layout(size_t width, size_t height)
+  : m_width{width},
+    m_height{height},
+    m_block_width{width},
+    m_block_height{height}
+  {
+  }
+  Pixel_layout(size_t width, size_t height, size_t block_width, size_t block_height)
+  : m_width{width},
+    m_height{height},
+    m_block_width{std::max<size_t>(block_width, 1)},
+    m_block_height{std::max<size_t>(block_height, 1)},
+    m_columns{(width + m_block_width - 1) / m_block_width},
+    m_blocked{true}
+  {
+  }
+  Pixel_layout(const Pixel_layout&) = default;
+  Pixel_layout(Pixel_layout&&) = default;
+  ~Pixel_layout() = default;
+
+  Pixel_layout& operator=(const Pixel_layout&) = default;
+  Pixel_layout& operator=(Pixel_layout&&) = default;
+
+  bool blocked() const
+  {
+    return m_blocked;
+  }
+
+  size_t block_width() const
+  {
+    return m_block_width;
+  }
+
+  size_t block_height() const
+  {
+    return m_block_height;
+  }
+
+  // Pixels the buffer holds, padding included.
+  size_t size() const
+  {
+    if (!m_blocked)
+    {
+      return m_width * m_height;
+    }
+
+    auto rows = (m_height + m_block_height - 1) / m_block_height;
+    return m_columns * rows * m_block_width * m_block_height;
+  }
+
+  size_t offset(size_t x, size_t y) const
+  {
+    if (!m_blocked)
+    {
+      return x + y * m_width;
+    }
+
+    auto block = x / m_block_width + (y / m_block_height) * m_columns;
+    return block * m_block_width * m_block_height + (y % m_block_height) * m_block_width + x % m_block_width;
+  }
+
+  // Pixels from x to the right of the view that follow each other in memory, on any row.
+  size_t run(size_t x) const
+  {
+    if (!m_blocked)
+    {
+      return m_width - x;
+    }
+
+    return std::min(m_block_width - x % m_block_width, m_width - x);
+  }
+
+  // Pixels from y down the view whose rows are stride() apart in memory, in any column.
+  size_t rows(size_t y) const
+  {
+    if (!m_blocked)
+    {
+      return m_height - y;
+    }
+
+    return std::min(m_block_height - y % m_block_height, m_height - y);
+  }
+
+  size_t stride() const
+  {
+    return m_block_width;
+  }
+
+  // Copies the rectangle of buffer, laid out like this, in from pixels whose rows are stride apart, a run at a time.
+  template <typename T>
+  void write(T* buffer, const View<size_t>& rectangle, const T* pixels, size_t stride) const
+  {
+    for (size_t y = rectangle.top; y < rectangle.bottom; ++y)
+    {
+      const auto* from = pixels + (y - rectangle.top) * stride;
+      for (size_t x = rectangle.left; x < rectangle.right;)
+      {
+        auto count = std::min(run(x), rectangle.right - x);
+        std::memcpy(buffer + offset(x, y), from + (x - rectangle.left), count * sizeof(T));
+        x += count;
+      }
+    }
+  }
+
+  // Copies the rectangle of buffer out to pixels, whose rows are stride apart.
+  template <typename T>
+  void read(const T* buffer, const View<size_t>& rectangle, T* pixels, size_t stride) const
+  {
+    for (size_t y = rectangle.top; y < rectangle.bottom; ++y)
+    {
+      auto* to = pixels + (y - rectangle.top) * stride;
+      for (size_t x = rectangle.left; x < rectangle.right;)
+      {
+        auto count = std::min(run(x), rectangle.right - x);
+        std::memcpy(to + (x - rectangle.left), buffer + offset(x, y), count * sizeof(T));
+        x += count;
+      }
+    }
+  }
+
+private:
+  size_t m_width{0};
+  size_t m_height{0};
+  size_t m_block_width{0};
+  size_t m_block_height{0};
+  size_t m_columns{1};
+  bool m_blocked{false};
+};
+
 class Fractal_view final
 {
 public:
   using Pixel_view = View<std::size_t>;
   using Complex_view = View<double>;
+  using Extended_complex_view = View<Quad_double>;
 
   Fractal_view() = default;
   Fractal_view(Pixel_view pixel_view, Complex_view complex_view, std::shared_ptr<uint32_t> buffer)
   : m_pixel_view{std::move(pixel_view)},
     m_complex_view{std::move(complex_view)},
-    m_buffer{std::move(buffer)}
+    m_buffer{std::move(buffer)},
+    m_layout{m_pixel_view.width(), m_pixel_view.height()}
   {
   }
   Fractal_view(Pixel_view pixel_view, Complex_view complex_view)
   : m_pixel_view{std::move(pixel_view)},
     m_complex_view{std::move(complex_view)},
-    m_buffer{std::shared_ptr<uint32_t>(new uint32_t[m_pixel_view.width() * m_pixel_view.height()], std::default_delete<uint32_t[]>())}
+    m_buffer{Framebuffer_pool::shared()->acquire<uint32_t>(m_pixel_view.width() * m_pixel_view.height())},
+    m_layout{m_pixel_view.width(), m_pixel_view.height()}
+  {
+  }
+  // Views deeper than doubles can resolve keep their exact coordinates in the extended complex view, the complex view
+  // holds the nearest doubles.
+  Fractal_view(Pixel_view pixel_view, Extended_complex_view extended_complex_view)
+  : m_pixel_view{std::move(pixel_view)},
+    m_complex_view{extended_complex_view.left[0], extended_complex_view.top[0], extended_complex_view.right[0], extended_complex_view.bottom[0]},
+    m_extended_complex_view{std::move(extended_complex_view)},
+    m_extended{true},
+    m_buffer{Framebuffer_pool::shared()->acquire<uint32_t>(m_pixel_view.width() * m_pixel_view.height())},
+    m_layout{m_pixel_view.width(), m_pixel_view.height()}
   {
   }
   Fractal_view(const Fractal_view&) = default;
@@ -65,6 +224,22 @@ public:
     return m_complex_view;
   }
   
+  // The exact coordinates when the view was built from them, the complex view otherwise.
+  Extended_complex_view extended_complex_view() const
+  {
+    if (m_extended)
+    {
+      return m_extended_complex_view;
+    }
+
+    return Extended_complex_view{m_complex_view.left, m_complex_view.top, m_complex_view.right, m_complex_view.bottom};
+  }
+
+  bool extended() const
+  {
+    return m_extended;
+  }
+  
   std::shared_ptr<uint32_t>& buffer()
   {
     return m_buffer;
@@ -74,11 +249,130 @@ public:
   {
     return m_buffer;
   }
+
+  // How the pixels are laid out in buffer(), linear unless set_blocked_layout was called.
+  const Pixel_layout& layout() const
+  {
+    return m_layout;
+  }
+
+  // Lays the buffer out in blocks of block_width x block_height pixels (see Pixel_layout), the tile size the view is
+  // rendered with making each tile contiguous.  The pixels are carried over into a new buffer, views sharing the old
+  // one keep it as it was.
+  void set_blocked_layout(size_t block_width, size_t block_height)
+  {
+    auto pixels = m_buffer ? linear_buffer() : nullptr;
+    m_layout = Pixel_layout{m_pixel_view.width(), m_pixel_view.height(), block_width, block_height};
+    m_buffer = Framebuffer_pool::shared()->acquire<uint32_t>(m_layout.size());
+    if (pixels)
+    {
+      write(Pixel_view{0, 0, m_pixel_view.width(), m_pixel_view.height()}, pixels.get(), m_pixel_view.width());
+    }
+  }
+
+  uint32_t& pixel(size_t x, size_t y)
+  {
+    return m_buffer.get()[m_layout.offset(x, y)];
+  }
+
+  uint32_t pixel(size_t x, size_t y) const
+  {
+    return m_buffer.get()[m_layout.offset(x, y)];
+  }
+
+  // The pixels of the tile where they are in the buffer, ready to be written out as a Response_view.  The tile has to
+  // sit within one block of a blocked layout, any other gives an empty span.
+  Argb_span tile_span(const Pixel_view& tile) const
+  {
+    if (tile.width() == 0 || tile.height() == 0 || m_layout.run(tile.left) < tile.width() || m_layout.rows(tile.top) < tile.height())
+    {
+      return Argb_span{};
+    }
+
+    return Argb_span{m_buffer.get() + m_layout.offset(tile.left, tile.top), tile.width(), tile.height(), m_layout.stride()};
+  }
+
+  // Copies the rectangle in from pixels, whose rows are stride apart.
+  void write(const Pixel_view& rectangle, const uint32_t* pixels, size_t stride)
+  {
+    m_layout.write(m_buffer.get(), rectangle, pixels, stride);
+  }
+
+  // Copies the rectangle out to pixels, whose rows are stride apart.
+  void read(const Pixel_view& rectangle, uint32_t* pixels, size_t stride) const
+  {
+    m_layout.read(m_buffer.get(), rectangle, pixels, stride);
+  }
+
+  // The pixels row after row across the view, for output that expects them so: the buffer itself when the layout is
+  // linear, a copy otherwise.
+  std::shared_ptr<uint32_t> linear_buffer() const
+  {
+    if (!m_layout.blocked())
+    {
+      return m_buffer;
+    }
+
+    auto width = m_pixel_view.width();
+    auto height = m_pixel_view.height();
+    auto buffer = Framebuffer_pool::shared()->acquire<uint32_t>(width * height);
+    read(Pixel_view{0, 0, width, height}, buffer.get(), width);
+    return buffer;
+  }
+
+  // Escape counts of the pixels, empty unless enabled with set_iteration_buffer.
+  const Iteration_buffer& iteration_buffer() const
+  {
+    return m_iteration_buffer;
+  }
+
+  // Makes the generator keep the escape counts of the view (and their smooth counts) next to the colors, so the
+  // view can be recolored without iterating again.  uint16 counts are left as they are by renders with max_iterations
+  // of UINT16_MAX or more, which color the view directly.
+  void set_iteration_buffer(Iteration_count count, bool smooth = false)
+  {
+    m_iteration_buffer = Iteration_buffer{m_pixel_view.width() * m_pixel_view.height(), count, smooth};
+  }
+
+  // Where the iteration of each pixel stopped, empty unless enabled with set_iteration_state.
+  const Iteration_state& iteration_state() const
+  {
+    return m_iteration_state;
+  }
+
+  // Makes the generator keep z and the iteration count of every pixel, so rendering the view again with a higher
+  // max_iterations only continues the pixels that hadn't escaped (see Mandlebrot_function::resume_tile).  The
+  // escape counts are needed to color the pixels that are reused, a view without an iteration buffer gets a uint32
+  // one.
+  void set_iteration_state()
+  {
+    m_iteration_state = Iteration_state{m_pixel_view.width() * m_pixel_view.height()};
+    if (m_iteration_buffer.empty())
+    {
+      set_iteration_buffer(Iteration_count::uint32);
+    }
+  }
+
+  // Distance in the complex plane between neighbouring pixels, the smaller of the horizontal and vertical steps.
+  double pixel_spacing() const
+  {
+    // The double view of a deep view can collapse to a few ulps, its size is only exact in the extended view.
+    auto complex_width = m_extended ? m_extended_complex_view.width()[0] : m_complex_view.width();
+    auto complex_height = m_extended ? m_extended_complex_view.height()[0] : m_complex_view.height();
+    auto width = m_pixel_view.width() > 0 ? complex_width / static_cast<double>(m_pixel_view.width()) : 0.0;
+    auto height = m_pixel_view.height() > 0 ? complex_height / static_cast<double>(m_pixel_view.height()) : 0.0;
+    return std::min(width, height);
+  }
   
 private:
   Pixel_view m_pixel_view;
   Complex_view m_complex_view;
+  Extended_complex_view m_extended_complex_view;
+  bool m_extended{false};
   std::shared_ptr<uint32_t> m_buffer;
+  Pixel_layout m_layout;
+  Iteration_buffer m_iteration_buffer;
+  Iteration_state m_iteration_state;
 };
 
 }
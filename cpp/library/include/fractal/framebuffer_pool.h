@@ -0,0 +1,343 @@
+//
+//  framebuffer_pool.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef framebuffer_pool_h
+#define framebuffer_pool_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace Fractal
+{
+
+// What the large buffers of a Framebuffer_pool are backed by.  Huge pages cut the page faults and TLB misses of a
+// gigapixel view by 512, explicit ones need pages reserved with the system (vm.nr_hugepages on Linux) and fall back
+// to transparent ones when there are none.  Only Linux maps huge pages, elsewhere every buffer comes from the heap.
+enum class Page_backing : uint8_t
+{
+  normal,
+  transparent_huge,
+  huge
+};
+
+// Buffers of pixels, or of anything else a view keeps per pixel, reused from one view to the next rather than
+// allocated and faulted in afresh for every frame.  Buffers are 64 byte aligned, so a row of SIMD lanes never
+// straddles a cache line, and come in size classes: powers of two below s_huge_page_size, whole huge pages above.
+// A buffer goes back to the pool when the last shared_ptr to it is dropped, on whichever thread that is, and is
+// handed out again to the next request of its size class.  Large buffers are faulted in across several threads
+// when first mapped.  The contents of a buffer are left as the last view had them.
+class Framebuffer_pool final
+{
+public:
+  static constexpr size_t s_alignment = 64;
+  static constexpr size_t s_huge_page_size = size_t{2} << 20;
+
+  explicit Framebuffer_pool(Page_backing page_backing = Page_backing::transparent_huge, size_t capacity = s_default_capacity)
+  : m_state{std::make_shared<State_>(page_backing, capacity)}
+  {
+  }
+  Framebuffer_pool(const Framebuffer_pool&) = delete;
+  Framebuffer_pool(Framebuffer_pool&&) = delete;
+  // Buffers still out are freed rather than pooled when dropped.
+  ~Framebuffer_pool() = default;
+
+  Framebuffer_pool& operator=(const Framebuffer_pool&) = delete;
+  Framebuffer_pool& operator=(Framebuffer_pool&&) = delete;
+
+  // Pool shared by the whole process, Fractal_view takes its buffers from it.
+  static std::shared_ptr<Framebuffer_pool> shared()
+  {
+    static auto pool = std::make_shared<Framebuffer_pool>();
+    return pool;
+  }
+
+  // A buffer of count elements, null for none.
+  template <typename T>
+  std::shared_ptr<T> acquire(size_t count)
+  {
+    if (count == 0)
+    {
+      return nullptr;
+    }
+
+    auto block = take_(size_class_(count * sizeof(T)));
+    auto state = std::weak_ptr<State_>{m_state};
+    return std::shared_ptr<T>(static_cast<T*>(block.memory), [state, block](T*)
+    {
+      recycle_(state, block);
+    });
+  }
+
+  Page_backing page_backing() const
+  {
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    return m_state->page_backing;
+  }
+
+  // Applies to the buffers allocated from then on, those pooled already keep theirs.
+  void set_page_backing(Page_backing page_backing)
+  {
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    m_state->page_backing = page_backing;
+  }
+
+  // Bytes of buffers the pool keeps for reuse at most, a buffer dropped past that is freed.
+  size_t capacity() const
+  {
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    return m_state->capacity;
+  }
+
+  void set_capacity(size_t capacity)
+  {
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    m_state->capacity = capacity;
+  }
+
+  // Bytes of the buffers waiting in the pool.
+  size_t idle_bytes() const
+  {
+    std::lock_guard<std::mutex> lock{m_state->mutex};
+    return m_state->idle_bytes;
+  }
+
+  // Frees the buffers waiting in the pool.
+  void trim()
+  {
+    auto idle = std::map<size_t, std::vector<Block_>>{};
+    {
+      std::lock_guard<std::mutex> lock{m_state->mutex};
+      idle.swap(m_state->idle);
+      m_state->idle_bytes = 0;
+    }
+    release_(idle);
+  }
+
+private:
+  struct Block_
+  {
+    void* memory;
+    size_t bytes;
+    bool mapped;
+  };
+
+  struct State_
+  {
+    State_(Page_backing page_backing_, size_t capacity_)
+    : page_backing{page_backing_},
+      capacity{capacity_}
+    {
+    }
+    State_(const State_&) = delete;
+    State_(State_&&) = delete;
+    ~State_()
+    {
+      release_(idle);
+    }
+
+    State_& operator=(const State_&) = delete;
+    State_& operator=(State_&&) = delete;
+
+    mutable std::mutex mutex;
+    Page_backing page_backing;
+    size_t capacity;
+    // Buffers waiting to be reused, by size class.
+    std::map<size_t, std::vector<Block_>> idle;
+    size_t idle_bytes{0};
+  };
+
+  static constexpr size_t s_default_capacity = size_t{1} << 30;
+  static constexpr size_t s_minimum_size_class = 4096;
+  // Buffers of at least this many bytes are faulted in by several threads, each a chunk of at least s_prefault_chunk.
+  static constexpr size_t s_prefault_threshold = size_t{32} << 20;
+  static constexpr size_t s_prefault_chunk = size_t{16} << 20;
+
+  static size_t size_class_(size_t bytes)
+  {
+    if (bytes >= s_huge_page_size)
+    {
+      return (bytes + s_huge_page_size - 1) / s_huge_page_size * s_huge_page_size;
+    }
+
+    auto size_class = s_minimum_size_class;
+    while (size_class < bytes)
+    {
+      size_class *= 2;
+    }
+    return size_class;
+  }
+
+  Block_ take_(size_t bytes)
+  {
+    auto page_backing = Page_backing::normal;
+    {
+      std::lock_guard<std::mutex> lock{m_state->mutex};
+      auto found = m_state->idle.find(bytes);
+      if (found != m_state->idle.end() && !found->second.empty())
+      {
+        auto block = found->second.back();
+        found->second.pop_back();
+        m_state->idle_bytes -= block.bytes;
+        return block;
+      }
+      page_backing = m_state->page_backing;
+    }
+
+    auto block = allocate_(bytes, page_backing);
+    if (bytes >= s_prefault_threshold)
+    {
+      prefault_(block);
+    }
+    return block;
+  }
+
+  static void recycle_(const std::weak_ptr<State_>& weak_state, const Block_& block)
+  {
+    auto state = weak_state.lock();
+    if (state)
+    {
+      std::lock_guard<std::mutex> lock{state->mutex};
+      if (state->idle_bytes + block.bytes <= state->capacity)
+      {
+        state->idle[block.bytes].push_back(block);
+        state->idle_bytes += block.bytes;
+        return;
+      }
+    }
+    release_(block);
+  }
+
+  static Block_ allocate_(size_t bytes, Page_backing page_backing)
+  {
+#if defined(__linux__)
+    if (bytes >= s_huge_page_size && page_backing != Page_backing::normal)
+    {
+      if (page_backing == Page_backing::huge)
+      {
+        auto memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+          return Block_{memory, bytes, true};
+        }
+      }
+
+      // Mapped a huge page over and trimmed to a huge page boundary, so the kernel can back all of it with huge pages.
+      auto mapping = mmap(nullptr, bytes + s_huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mapping != MAP_FAILED)
+      {
+        auto start = reinterpret_cast<uintptr_t>(mapping);
+        auto aligned = (start + s_huge_page_size - 1) / s_huge_page_size * s_huge_page_size;
+        if (aligned > start)
+        {
+          munmap(mapping, aligned - start);
+        }
+        munmap(reinterpret_cast<void*>(aligned + bytes), start + s_huge_page_size - aligned);
+        auto memory = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+        madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+        return Block_{memory, bytes, true};
+      }
+    }
+#else
+    (void)page_backing;
+#endif
+
+#if defined(_WIN32)
+    auto memory = _aligned_malloc(bytes, s_alignment);
+#else
+    auto memory = static_cast<void*>(nullptr);
+    if (posix_memalign(&memory, s_alignment, bytes) != 0)
+    {
+      memory = nullptr;
+    }
+#endif
+    if (!memory)
+    {
+      throw std::bad_alloc{};
+    }
+    return Block_{memory, bytes, false};
+  }
+
+  static void release_(const Block_& block)
+  {
+#if defined(__linux__)
+    if (block.mapped)
+    {
+      munmap(block.memory, block.bytes);
+      return;
+    }
+#endif
+#if defined(_WIN32)
+    _aligned_free(block.memory);
+#else
+    std::free(block.memory);
+#endif
+  }
+
+  static void release_(const std::map<size_t, std::vector<Block_>>& blocks)
+  {
+    for (const auto& size_class : blocks)
+    {
+      for (const auto& block : size_class.second)
+      {
+        release_(block);
+      }
+    }
+  }
+
+  // Touches every page of the block, a chunk per thread, so the faults of a fresh mapping are taken up front and in
+  // parallel rather than one at a time by whoever first writes each page.
+  static void prefault_(const Block_& block)
+  {
+    const auto page_size = size_t{4096};
+    auto touch = [page_size](char* begin, char* end)
+    {
+      for (auto page = begin; page < end; page += page_size)
+      {
+        *page = 0;
+      }
+    };
+
+    auto hardware_threads = std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t{1});
+    auto thread_count = std::min(hardware_threads, block.bytes / s_prefault_chunk);
+    auto begin = static_cast<char*>(block.memory);
+    auto chunk = (block.bytes / std::max(thread_count, size_t{1}) + page_size - 1) / page_size * page_size;
+    auto threads = std::vector<std::thread>{};
+    for (size_t i = 1; i < thread_count; ++i)
+    {
+      threads.emplace_back(touch, begin + i * chunk, begin + std::min(block.bytes, (i + 1) * chunk));
+    }
+    touch(begin, begin + std::min(block.bytes, chunk));
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+private:
+  std::shared_ptr<State_> m_state;
+};
+
+}
+
+#endif /* framebuffer_pool_h */
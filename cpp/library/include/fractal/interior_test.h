@@ -0,0 +1,274 @@
+//
+//  interior_test.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef interior_test_h
+#define interior_test_h
+
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Fractal
+{
+
+enum class Interior_region : uint8_t
+{
+  none,
+  main_cardioid,
+  period_2_bulb,
+  higher_order_bulb
+};
+
+// Number of pixels each test classified as interior.
+struct Interior_statistics
+{
+  std::atomic<uint64_t> main_cardioid{0};
+  std::atomic<uint64_t> period_2_bulb{0};
+  std::atomic<uint64_t> higher_order_bulb{0};
+
+  uint64_t total() const
+  {
+    return main_cardioid.load() + period_2_bulb.load() + higher_order_bulb.load();
+  }
+
+  void reset()
+  {
+    main_cardioid = 0;
+    period_2_bulb = 0;
+    higher_order_bulb = 0;
+  }
+};
+
+// Closed form membership checks for the largest components of the Mandlebrot set, so that points inside them can be
+// classified without running the escape loop up to max_iterations.
+class Interior_test final
+{
+public:
+  Interior_test() = default;
+  Interior_test(bool enabled, bool higher_order_bulbs)
+  : m_enabled{enabled},
+    m_higher_order_bulbs{higher_order_bulbs}
+  {
+  }
+  Interior_test(const Interior_test&) = default;
+  Interior_test(Interior_test&&) = default;
+  ~Interior_test() = default;
+
+  Interior_test& operator=(const Interior_test&) = default;
+  Interior_test& operator=(Interior_test&&) = default;
+
+  Interior_region invoke(std::complex<double> c) const
+  {
+    if (!m_enabled)
+    {
+      return Interior_region::none;
+    }
+
+    if (in_main_cardioid(c))
+    {
+      return Interior_region::main_cardioid;
+    }
+
+    if (in_period_2_bulb(c))
+    {
+      return Interior_region::period_2_bulb;
+    }
+
+    if (m_higher_order_bulbs && in_higher_order_bulb(c))
+    {
+      return Interior_region::higher_order_bulb;
+    }
+
+    return Interior_region::none;
+  }
+
+  Interior_region operator()(std::complex<double> c) const
+  {
+    return invoke(std::move(c));
+  }
+
+  // Adds counts gathered by the caller (indexed by Interior_region) to the shared statistics, if any.
+  void record(const uint64_t (&counts)[4]) const
+  {
+    if (!m_statistics)
+    {
+      return;
+    }
+
+    m_statistics->main_cardioid += counts[static_cast<size_t>(Interior_region::main_cardioid)];
+    m_statistics->period_2_bulb += counts[static_cast<size_t>(Interior_region::period_2_bulb)];
+    m_statistics->higher_order_bulb += counts[static_cast<size_t>(Interior_region::higher_order_bulb)];
+  }
+
+  static bool in_main_cardioid(std::complex<double> c)
+  {
+    auto x = c.real() - 0.25;
+    auto y_squared = c.imag() * c.imag();
+    auto q = x * x + y_squared;
+    return q * (q + x) <= 0.25 * y_squared;
+  }
+
+  static bool in_period_2_bulb(std::complex<double> c)
+  {
+    auto x = c.real() + 1.0;
+    return x * x + c.imag() * c.imag() <= 0.0625;
+  }
+
+  // The p/q bulbs hanging off the main cardioid are close to discs of radius sin(pi p / q) / q^2 tangent to it at
+  // the root of internal angle p / q.  Points near one are confirmed by locating the period q cycle with Newton's
+  // method and checking that it is attracting, which is exact membership of the bulb rather than the disc estimate.
+  static bool in_higher_order_bulb(std::complex<double> c)
+  {
+    static const auto bulbs = make_bulbs_();
+
+    for (const auto& bulb : bulbs)
+    {
+      if (std::norm(c - bulb.center) <= bulb.gate_radius_squared && has_attracting_cycle_(c, bulb.period))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  bool enabled() const
+  {
+    return m_enabled;
+  }
+
+  void set_enabled(bool enabled)
+  {
+    m_enabled = enabled;
+  }
+
+  bool higher_order_bulbs() const
+  {
+    return m_higher_order_bulbs;
+  }
+
+  void set_higher_order_bulbs(bool higher_order_bulbs)
+  {
+    m_higher_order_bulbs = higher_order_bulbs;
+  }
+
+  const std::shared_ptr<Interior_statistics>& statistics() const
+  {
+    return m_statistics;
+  }
+
+  // Copies of the test share the statistics, so one instance can collect the counts of a whole render.
+  void set_statistics(std::shared_ptr<Interior_statistics> statistics)
+  {
+    m_statistics = std::move(statistics);
+  }
+
+private:
+  static constexpr size_t s_max_bulb_period = 6;
+  static constexpr double s_gate_factor = 1.25;
+  static constexpr size_t s_settle_iterations = 64;
+  static constexpr size_t s_newton_iterations = 16;
+
+  struct Bulb_
+  {
+    std::complex<double> center;
+    double gate_radius_squared;
+    size_t period;
+  };
+
+  static std::vector<Bulb_> make_bulbs_()
+  {
+    static const auto pi = std::acos(-1.0);
+
+    auto bulbs = std::vector<Bulb_>{};
+    for (size_t q = 3; q <= s_max_bulb_period; ++q)
+    {
+      for (size_t p = 1; p < q; ++p)
+      {
+        if (gcd_(p, q) != 1)
+        {
+          continue;
+        }
+
+        auto angle = std::polar(1.0, 2.0 * pi * p / q);
+        auto root = angle / 2.0 - angle * angle / 4.0;
+        auto normal = angle * (1.0 - angle);
+        normal /= std::abs(normal);
+        auto radius = std::sin(pi * p / q) / static_cast<double>(q * q);
+        auto gate_radius = s_gate_factor * radius;
+        bulbs.push_back(Bulb_{root + normal * radius, gate_radius * gate_radius, q});
+      }
+    }
+    return bulbs;
+  }
+
+  static size_t gcd_(size_t a, size_t b)
+  {
+    while (b != 0)
+    {
+      auto t = a % b;
+      a = b;
+      b = t;
+    }
+    return a;
+  }
+
+  static bool has_attracting_cycle_(std::complex<double> c, size_t period)
+  {
+    // Let the orbit settle close to the cycle first so Newton's method starts inside its basin.
+    auto z = std::complex<double>{};
+    for (size_t i = 0; i < s_settle_iterations; ++i)
+    {
+      z = z * z + c;
+      if (std::norm(z) > 4)
+      {
+        return false;
+      }
+    }
+
+    for (size_t i = 0; i < s_newton_iterations; ++i)
+    {
+      auto w = z;
+      auto derivative = std::complex<double>{1.0};
+      for (size_t k = 0; k < period; ++k)
+      {
+        derivative *= 2.0 * w;
+        w = w * w + c;
+      }
+
+      auto step = (w - z) / (derivative - 1.0);
+      z -= step;
+      if (std::norm(step) < 1e-24)
+      {
+        break;
+      }
+    }
+
+    auto w = z;
+    auto multiplier = std::complex<double>{1.0};
+    for (size_t k = 0; k < period; ++k)
+    {
+      multiplier *= 2.0 * w;
+      w = w * w + c;
+    }
+
+    return std::norm(w - z) < 1e-20 && std::norm(multiplier) < 1.0;
+  }
+
+private:
+  bool m_enabled{true};
+  bool m_higher_order_bulbs{false};
+  std::shared_ptr<Interior_statistics> m_statistics;
+};
+
+}
+
+#endif /* interior_test_h */
@@ -0,0 +1,103 @@
+//
+//  iteration_buffer.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef iteration_buffer_h
+#define iteration_buffer_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "framebuffer_pool.h"
+
+namespace Fractal
+{
+
+// Width of the escape counts kept by an Iteration_buffer.  uint16 halves the memory but only holds max_iterations
+// below UINT16_MAX, Distributed_generator leaves it out of renders that iterate further.
+enum class Iteration_count : uint8_t
+{
+  none,
+  uint16,
+  uint32
+};
+
+// Raw escape counts of every pixel of a view, and optionally their fractional (smooth) counts, kept apart from the
+// ARGB buffer so the view can be recolored without iterating again (see Color_table).
+class Iteration_buffer final
+{
+public:
+  Iteration_buffer() = default;
+  Iteration_buffer(size_t size, Iteration_count count, bool smooth)
+  : m_count{count}
+  {
+    if (count == Iteration_count::uint16)
+    {
+      m_counts16 = Framebuffer_pool::shared()->acquire<uint16_t>(size);
+    }
+    else if (count == Iteration_count::uint32)
+    {
+      m_counts32 = Framebuffer_pool::shared()->acquire<uint32_t>(size);
+    }
+
+    if (smooth && count != Iteration_count::none)
+    {
+      m_smooth = Framebuffer_pool::shared()->acquire<float>(size);
+    }
+  }
+  Iteration_buffer(const Iteration_buffer&) = default;
+  Iteration_buffer(Iteration_buffer&&) = default;
+  ~Iteration_buffer() = default;
+
+  Iteration_buffer& operator=(const Iteration_buffer&) = default;
+  Iteration_buffer& operator=(Iteration_buffer&&) = default;
+
+  Iteration_count count() const
+  {
+    return m_count;
+  }
+
+  bool empty() const
+  {
+    return m_count == Iteration_count::none;
+  }
+
+  // The counts when they are of type Count, null otherwise.
+  template <typename Count>
+  Count* counts() const
+  {
+    return counts_(static_cast<Count*>(nullptr));
+  }
+
+  // Null unless the buffer was built with smooth counts.
+  float* smooth() const
+  {
+    return m_smooth.get();
+  }
+
+private:
+  uint16_t* counts_(uint16_t*) const
+  {
+    return m_counts16.get();
+  }
+
+  uint32_t* counts_(uint32_t*) const
+  {
+    return m_counts32.get();
+  }
+
+private:
+  Iteration_count m_count{Iteration_count::none};
+  std::shared_ptr<uint16_t> m_counts16;
+  std::shared_ptr<uint32_t> m_counts32;
+  std::shared_ptr<float> m_smooth;
+};
+
+}
+
+#endif /* iteration_buffer_h */
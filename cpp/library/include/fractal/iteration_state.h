@@ -0,0 +1,92 @@
+//
+//  iteration_state.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef iteration_state_h
+#define iteration_state_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "framebuffer_pool.h"
+
+namespace Fractal
+{
+
+// Where the iteration of every pixel of a view stopped: z and the number of iterations done so far.  A render with
+// a higher max_iterations continues the pixels that hadn't escaped from there instead of starting over from z = c,
+// pixels that escaped are reused as they are (see Escape_time_kernel::invoke_resume).  The state only holds for the
+// coordinates of the view it was made for, it has to be reset when the view moves.
+class Iteration_state final
+{
+public:
+  // Pixel that was never iterated.
+  static constexpr uint32_t unset = UINT32_MAX;
+  // Pixel known to never escape, whatever the iteration limit (interior test or periodicity).
+  static constexpr uint32_t interior = UINT32_MAX - 1;
+
+  Iteration_state() = default;
+  Iteration_state(size_t size)
+  : m_size{size},
+    m_real{Framebuffer_pool::shared()->acquire<double>(size)},
+    m_imaginary{Framebuffer_pool::shared()->acquire<double>(size)},
+    m_iterations{Framebuffer_pool::shared()->acquire<uint32_t>(size)}
+  {
+    reset();
+  }
+  Iteration_state(const Iteration_state&) = default;
+  Iteration_state(Iteration_state&&) = default;
+  ~Iteration_state() = default;
+
+  Iteration_state& operator=(const Iteration_state&) = default;
+  Iteration_state& operator=(Iteration_state&&) = default;
+
+  bool empty() const
+  {
+    return m_size == 0;
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  // Real part of the last z of each pixel.
+  double* real() const
+  {
+    return m_real.get();
+  }
+
+  double* imaginary() const
+  {
+    return m_imaginary.get();
+  }
+
+  // Iterations done for each pixel, the escape count when |z| > 2, unset or interior otherwise.
+  uint32_t* iterations() const
+  {
+    return m_iterations.get();
+  }
+
+  // Forgets every pixel, the next render starts them all over.
+  void reset()
+  {
+    std::fill(m_iterations.get(), m_iterations.get() + m_size, unset);
+  }
+
+private:
+  size_t m_size{0};
+  std::shared_ptr<double> m_real;
+  std::shared_ptr<double> m_imaginary;
+  std::shared_ptr<uint32_t> m_iterations;
+};
+
+}
+
+#endif /* iteration_state_h */
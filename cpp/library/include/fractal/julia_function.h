@@ -12,6 +12,11 @@
 #include <complex>
 #include <functional>
 
+#include "colormap.h"
+#include "escape_time_kernel.h"
+#include "fractal_view.h"
+#include "symmetry.h"
+
 namespace Fractal
 {
 
@@ -33,34 +38,45 @@ public:
   
   uint64_t invoke(std::complex<double> z, std::shared_ptr<std::atomic<bool>>& cancel_token) const
   {
-    // Value is part of the Mandlebrot set, let's just represent that by the color black
-    static constexpr auto black = uint64_t{0xFF000000};
+    // Value is part of the Julia set
+    auto interior = uint64_t{(*m_color_table)(m_max_iterations)};
     
     auto iterations = m_max_iterations;
+    auto saved = z;
+    auto checkpoint = size_t{1};
     for (size_t i = 0; i < iterations; ++i)
     {
       if (z.real() * z.real() + z.imag() * z.imag() > 4)
       {
         // This value doesn't belong in the Mandlebrot set.  Apparently we are checking if Z is divergent
         // and if the distance of Z is more than 2 units from the origin then it will inevitably go to infinity.
-        auto t = static_cast<double>(i) / static_cast<double>(m_max_iterations);
-        
-        // Use smooth polynomials for r, g, b
-        auto r = static_cast<int8_t>(9*(1-t)*t*t*t*255);
-        auto g = static_cast<int8_t>(15*(1-t)*(1-t)*t*t*255);
-        auto b = static_cast<int8_t>(8.5*(1-t)*(1-t)*(1-t)*t*255);
-        return (0xff << 24) | (r << 16) | (g << 8) | b;
+        return (*m_color_table)(i);
       }
       
       z = z * z + m_k;
+
+      if (m_periodicity_tolerance > 0)
+      {
+        // The orbit came back to an earlier point, it is in a cycle and will never escape.
+        if (std::norm(z - saved) < m_periodicity_tolerance * m_periodicity_tolerance)
+        {
+          return interior;
+        }
+
+        if (i + 1 == checkpoint)
+        {
+          saved = z;
+          checkpoint *= 2;
+        }
+      }
       
-      if (*cancel_token)
+      if (i % s_cancel_check_interval == 0 && cancel_token->load(std::memory_order_relaxed))
       {
-        return black;
+        return interior;
       }
     }
     
-    return black;
+    return interior;
   }
   
   uint64_t operator()(std::complex<double> z, std::shared_ptr<std::atomic<bool>>& cancel_token) const
@@ -68,6 +84,87 @@ public:
     return invoke(std::move(z), cancel_token);
   }
 
+  // Evaluates a whole row of pixels sharing the same imaginary coordinate through the SIMD escape time kernel.
+  void invoke_row(const double* real,
+                  double imaginary,
+                  size_t count,
+                  uint32_t* argb,
+                  const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    // The output row doubles as the iteration buffer, each count is replaced by its color in place.
+    kernel_()(real, imaginary, &m_k, count, m_max_iterations, argb, *cancel_token, m_lane_statistics.get());
+    m_color_table->invoke(argb, count, argb);
+  }
+
+  // Evaluates a width x height tile, pixel (x, y) being real[x] + imaginary[y] * i and landing in argb[x + y * stride].
+  void invoke_tile(const double* real,
+                   size_t width,
+                   const double* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    iterate_tile(real, width, imaginary, height, argb, nullptr, stride, cancel_token);
+    m_color_table->invoke_tile(argb, nullptr, width, height, stride, argb, stride);
+  }
+
+  // Escape counts of a width x height tile, pixel (x, y) landing in iterations[x + y * stride] and, when smooth
+  // isn't null, its fractional count in smooth[x + y * stride].  The tile is colored separately through
+  // color_table().
+  template <typename Count>
+  void iterate_tile(const double* real,
+                    size_t width,
+                    const double* imaginary,
+                    size_t height,
+                    Count* iterations,
+                    float* smooth,
+                    size_t stride,
+                    const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    // Narrow tiles are always streamed, see Mandlebrot_function::iterate_tile.
+    if (m_streaming || width < s_streaming_width)
+    {
+      kernel_().invoke_streaming(real,
+                                 width,
+                                 imaginary,
+                                 height,
+                                 &m_k,
+                                 m_max_iterations,
+                                 iterations,
+                                 stride,
+                                 *cancel_token,
+                                 m_lane_statistics.get(),
+                                 smooth);
+      return;
+    }
+
+    auto kernel = kernel_();
+    for (size_t y = 0; y < height; ++y)
+    {
+      kernel(real,
+             imaginary[y],
+             &m_k,
+             width,
+             m_max_iterations,
+             iterations + y * stride,
+             *cancel_token,
+             m_lane_statistics.get(),
+             smooth ? smooth + y * stride : nullptr);
+
+      if (cancel_token->load())
+      {
+        return;
+      }
+    }
+  }
+
+  // Julia sets are symmetric through the origin (see Generator_task_parameters::distribute).
+  Symmetry symmetry() const
+  {
+    return Symmetry::origin;
+  }
+
   size_t max_iterations() const
   {
     return m_max_iterations;
@@ -76,6 +173,63 @@ public:
   void set_max_iterations(size_t iterations)
   {
     m_max_iterations = iterations;
+    m_color_table = std::make_shared<const Color_table>(m_color_table->colormap(), m_max_iterations);
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_color_table->colormap();
+  }
+
+  void set_colormap(Colormap colormap)
+  {
+    m_color_table = std::make_shared<const Color_table>(std::move(colormap), m_max_iterations);
+  }
+
+  // Colors escape counts, shared by the copies of the function.
+  const std::shared_ptr<const Color_table>& color_table() const
+  {
+    return m_color_table;
+  }
+
+  bool streaming() const
+  {
+    return m_streaming;
+  }
+
+  // When enabled, invoke_tile refills a lane with the next pixel of the tile as soon as its current pixel is done.
+  void set_streaming(bool streaming)
+  {
+    m_streaming = streaming;
+  }
+
+  double periodicity_tolerance() const
+  {
+    return m_periodicity_tolerance;
+  }
+
+  // Orbits that return within the tolerance of an earlier point are treated as never escaping.  Zero disables the
+  // check.
+  void set_periodicity_tolerance(double tolerance)
+  {
+    m_periodicity_tolerance = tolerance;
+  }
+
+  // Picks a tolerance small enough relative to the pixel spacing of the view that no pixel changes color.
+  void enable_periodicity_checking(const Fractal_view& fractal_view)
+  {
+    m_periodicity_tolerance = Escape_time_kernel::periodicity_tolerance(fractal_view.pixel_spacing());
+  }
+
+  const std::shared_ptr<Lane_statistics>& lane_statistics() const
+  {
+    return m_lane_statistics;
+  }
+
+  // Copies of the function share the statistics, so one instance can collect the lane utilization of a whole render.
+  void set_lane_statistics(std::shared_ptr<Lane_statistics> lane_statistics)
+  {
+    m_lane_statistics = std::move(lane_statistics);
   }
   
   std::complex<double> k() const
@@ -88,9 +242,24 @@ public:
     m_k = std::move(k);
   }
 
+private:
+  static constexpr size_t s_cancel_check_interval = 256;
+  static constexpr size_t s_streaming_width = 8;
+
+  Escape_time_kernel kernel_() const
+  {
+    auto kernel = Escape_time_kernel{};
+    kernel.set_periodicity_tolerance(m_periodicity_tolerance);
+    return kernel;
+  }
+
 private:
   std::complex<double> m_k;
   size_t m_max_iterations{64};
+  std::shared_ptr<const Color_table> m_color_table{std::make_shared<const Color_table>(Colormap{}, m_max_iterations)};
+  bool m_streaming{false};
+  double m_periodicity_tolerance{0.0};
+  std::shared_ptr<Lane_statistics> m_lane_statistics;
 };
 
 }
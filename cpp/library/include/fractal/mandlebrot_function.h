@@ -12,6 +12,12 @@
 #include <complex>
 #include <functional>
 
+#include "colormap.h"
+#include "escape_time_kernel.h"
+#include "fractal_view.h"
+#include "interior_test.h"
+#include "symmetry.h"
+
 namespace Fractal
 {
 
@@ -32,35 +38,56 @@ public:
   
   uint32_t invoke(std::complex<double> z, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
   {
-    // Value is part of the Mandlebrot set, let's just represent that by the color black
-    static constexpr auto black = uint64_t{0xFF000000};
+    // Value is part of the Mandlebrot set
+    auto interior = (*m_color_table)(m_max_iterations);
     
     auto c = z;
     auto iterations = m_max_iterations;
+
+    auto region = m_interior_test(c);
+    if (region != Interior_region::none)
+    {
+      uint64_t counts[4] = {};
+      ++counts[static_cast<size_t>(region)];
+      m_interior_test.record(counts);
+      return interior;
+    }
+
+    auto saved = z;
+    auto checkpoint = size_t{1};
     for (size_t i = 0; i < iterations; ++i)
     {
       if (z.real() * z.real() + z.imag() * z.imag() > 4)
       {
         // This value doesn't belong in the Mandlebrot set.  Apparently we are checking if Z is divergent
         // and if the distance of Z is more than 2 units from the origin then it will inevitably go to infinity.
-        auto t = static_cast<double>(i) / static_cast<double>(iterations);
-        
-        // Use smooth polynomials for r, g, b
-        auto r = static_cast<int8_t>(9*(1-t)*t*t*t*255);
-        auto g = static_cast<int8_t>(15*(1-t)*(1-t)*t*t*255);
-        auto b = static_cast<int8_t>(8.5*(1-t)*(1-t)*(1-t)*t*255);
-        return (0xff << 24) | (r << 16) | (g << 8) | b;
+        return (*m_color_table)(i);
       }
       
       z = z * z + c;
+
+      if (m_periodicity_tolerance > 0)
+      {
+        // The orbit came back to an earlier point, it is in a cycle and will never escape.
+        if (std::norm(z - saved) < m_periodicity_tolerance * m_periodicity_tolerance)
+        {
+          return interior;
+        }
+
+        if (i + 1 == checkpoint)
+        {
+          saved = z;
+          checkpoint *= 2;
+        }
+      }
       
-      if (cancel_token->load())
+      if (i % s_cancel_check_interval == 0 && cancel_token->load(std::memory_order_relaxed))
       {
-        return black;
+        return interior;
       }
     }
     
-    return black;
+    return interior;
   }
   
   uint32_t operator()(std::complex<double> z, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
@@ -68,6 +95,158 @@ public:
     return invoke(std::move(z), cancel_token);
   }
 
+  // Evaluates a whole row of pixels sharing the same imaginary coordinate through the SIMD escape time kernel.
+  void invoke_row(const double* real,
+                  double imaginary,
+                  size_t count,
+                  uint32_t* argb,
+                  const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    // The output row doubles as the iteration buffer, each count is replaced by its color in place.
+    iterate_row_(real, imaginary, count, argb, static_cast<float*>(nullptr), *cancel_token);
+    m_color_table->invoke(argb, count, argb);
+  }
+
+  // Evaluates a width x height tile, pixel (x, y) being real[x] + imaginary[y] * i and landing in argb[x + y * stride].
+  void invoke_tile(const double* real,
+                   size_t width,
+                   const double* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    iterate_tile(real, width, imaginary, height, argb, nullptr, stride, cancel_token);
+    m_color_table->invoke_tile(argb, nullptr, width, height, stride, argb, stride);
+  }
+
+  // Single precision tile, for views shallow enough that floats still resolve every pixel (see select_precision).
+  void invoke_tile(const float* real,
+                   size_t width,
+                   const float* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    iterate_tile(real, width, imaginary, height, argb, nullptr, stride, cancel_token);
+    m_color_table->invoke_tile(argb, nullptr, width, height, stride, argb, stride);
+  }
+
+  // Escape counts of a width x height tile, pixel (x, y) landing in iterations[x + y * stride] and, when smooth
+  // isn't null, its fractional count in smooth[x + y * stride].  The tile is colored separately through
+  // color_table().
+  template <typename Real, typename Count>
+  void iterate_tile(const Real* real,
+                    size_t width,
+                    const Real* imaginary,
+                    size_t height,
+                    Count* iterations,
+                    float* smooth,
+                    size_t stride,
+                    const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    // Rows narrower than a vector would leave most lanes idle, narrow tiles such as the columns subdivision evaluates
+    // are always streamed.
+    if (m_streaming || width < s_streaming_width)
+    {
+      auto kernel = kernel_();
+      if (m_interior_test.enabled())
+      {
+        for (size_t y = 0; y < height; ++y)
+        {
+          classify_(real, imaginary[y], width, iterations + y * stride, smooth ? smooth + y * stride : nullptr);
+        }
+        kernel.set_skip_resolved(true);
+      }
+
+      kernel.invoke_streaming(real,
+                              width,
+                              imaginary,
+                              height,
+                              nullptr,
+                              m_max_iterations,
+                              iterations,
+                              stride,
+                              *cancel_token,
+                              m_lane_statistics.get(),
+                              smooth);
+      return;
+    }
+
+    for (size_t y = 0; y < height; ++y)
+    {
+      iterate_row_(real, imaginary[y], width, iterations + y * stride, smooth ? smooth + y * stride : nullptr, *cancel_token);
+
+      if (cancel_token->load())
+      {
+        return;
+      }
+    }
+  }
+
+  // Escape counts of a width x height tile continued from the state an earlier render left in z_real, z_imaginary and
+  // progress (see Iteration_state), all of them indexed like iterations.  Pixels that escaped before are reused,
+  // the others carry on up to max_iterations.  The interior test resolves the pixels met for the first time.
+  template <typename Count>
+  void resume_tile(const double* real,
+                   size_t width,
+                   const double* imaginary,
+                   size_t height,
+                   double* z_real,
+                   double* z_imaginary,
+                   uint32_t* progress,
+                   Count* iterations,
+                   float* smooth,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    if (m_interior_test.enabled())
+    {
+      uint64_t counts[4] = {};
+      for (size_t y = 0; y < height; ++y)
+      {
+        for (size_t x = 0; x < width; ++x)
+        {
+          auto& state = progress[x + y * stride];
+          if (state != Iteration_state::unset)
+          {
+            continue;
+          }
+
+          auto region = m_interior_test(std::complex<double>{real[x], imaginary[y]});
+          ++counts[static_cast<size_t>(region)];
+          if (region != Interior_region::none)
+          {
+            state = Iteration_state::interior;
+          }
+        }
+      }
+      m_interior_test.record(counts);
+    }
+
+    kernel_().invoke_resume(real,
+                            width,
+                            imaginary,
+                            height,
+                            nullptr,
+                            m_max_iterations,
+                            z_real,
+                            z_imaginary,
+                            progress,
+                            iterations,
+                            smooth,
+                            stride,
+                            *cancel_token,
+                            m_lane_statistics.get());
+  }
+
+  // The set is symmetric about the real axis (see Generator_task_parameters::distribute).
+  Symmetry symmetry() const
+  {
+    return Symmetry::real_axis;
+  }
+
   size_t max_iterations() const
   {
     return m_max_iterations;
@@ -76,10 +255,157 @@ public:
   void set_max_iterations(size_t iterations)
   {
     m_max_iterations = iterations;
+    m_color_table = std::make_shared<const Color_table>(m_color_table->colormap(), m_max_iterations);
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_color_table->colormap();
+  }
+
+  void set_colormap(Colormap colormap)
+  {
+    m_color_table = std::make_shared<const Color_table>(std::move(colormap), m_max_iterations);
+  }
+
+  // Colors escape counts, shared by the copies of the function.
+  const std::shared_ptr<const Color_table>& color_table() const
+  {
+    return m_color_table;
+  }
+
+  bool streaming() const
+  {
+    return m_streaming;
+  }
+
+  // When enabled, invoke_tile refills a lane with the next pixel of the tile as soon as its current pixel is done.
+  void set_streaming(bool streaming)
+  {
+    m_streaming = streaming;
+  }
+
+  const Interior_test& interior_test() const
+  {
+    return m_interior_test;
+  }
+
+  // The main cardioid and period 2 bulb checks are on by default, higher order bulbs have to be enabled on the test.
+  void set_interior_test(Interior_test interior_test)
+  {
+    m_interior_test = std::move(interior_test);
+  }
+
+  double periodicity_tolerance() const
+  {
+    return m_periodicity_tolerance;
+  }
+
+  // Orbits that return within the tolerance of an earlier point are treated as never escaping.  Zero disables the
+  // check.
+  void set_periodicity_tolerance(double tolerance)
+  {
+    m_periodicity_tolerance = tolerance;
+  }
+
+  // Picks a tolerance small enough relative to the pixel spacing of the view that no pixel changes color.
+  void enable_periodicity_checking(const Fractal_view& fractal_view)
+  {
+    m_periodicity_tolerance = Escape_time_kernel::periodicity_tolerance(fractal_view.pixel_spacing());
+  }
+
+  const std::shared_ptr<Lane_statistics>& lane_statistics() const
+  {
+    return m_lane_statistics;
+  }
+
+  // Copies of the function share the statistics, so one instance can collect the lane utilization of a whole render.
+  void set_lane_statistics(std::shared_ptr<Lane_statistics> lane_statistics)
+  {
+    m_lane_statistics = std::move(lane_statistics);
+  }
+
+private:
+  static constexpr size_t s_cancel_check_interval = 256;
+  static constexpr size_t s_streaming_width = 8;
+
+  Escape_time_kernel kernel_() const
+  {
+    auto kernel = Escape_time_kernel{};
+    kernel.set_periodicity_tolerance(m_periodicity_tolerance);
+    return kernel;
+  }
+
+  template <typename Real, typename Count>
+  void iterate_row_(const Real* real,
+                    Real imaginary,
+                    size_t count,
+                    Count* iterations,
+                    float* smooth,
+                    const std::atomic<bool>& cancel_token) const
+  {
+    if (!m_interior_test.enabled())
+    {
+      kernel_().invoke(real, imaginary, nullptr, count, m_max_iterations, iterations, cancel_token, m_lane_statistics.get(), smooth);
+      return;
+    }
+
+    classify_(real, imaginary, count, iterations, smooth);
+
+    // Only the runs of pixels the interior test couldn't resolve go through the kernel.
+    const auto pending = static_cast<Count>(Escape_time_kernel::pending);
+    for (size_t n = 0; n < count;)
+    {
+      if (iterations[n] != pending)
+      {
+        ++n;
+        continue;
+      }
+
+      auto end = n;
+      while (end < count && iterations[end] == pending)
+      {
+        ++end;
+      }
+
+      kernel_().invoke(real + n,
+                       imaginary,
+                       nullptr,
+                       end - n,
+                       m_max_iterations,
+                       iterations + n,
+                       cancel_token,
+                       m_lane_statistics.get(),
+                       smooth ? smooth + n : nullptr);
+      n = end;
+    }
+  }
+
+  // Writes max_iterations for the pixels the interior test resolves and Escape_time_kernel::pending for the others.
+  template <typename Real, typename Count>
+  void classify_(const Real* real, Real imaginary, size_t count, Count* iterations, float* smooth) const
+  {
+    uint64_t counts[4] = {};
+    for (size_t n = 0; n < count; ++n)
+    {
+      auto region = m_interior_test(std::complex<double>{real[n], imaginary});
+      ++counts[static_cast<size_t>(region)];
+      iterations[n] = static_cast<Count>(region == Interior_region::none ? Escape_time_kernel::pending : m_max_iterations);
+      if (smooth)
+      {
+        smooth[n] = static_cast<float>(m_max_iterations);
+      }
+    }
+    m_interior_test.record(counts);
   }
 
 private:
   size_t m_max_iterations{64};
+  std::shared_ptr<const Color_table> m_color_table{std::make_shared<const Color_table>(Colormap{}, m_max_iterations)};
+  bool m_streaming{false};
+  double m_periodicity_tolerance{0.0};
+  std::shared_ptr<Lane_statistics> m_lane_statistics;
+  Interior_test m_interior_test;
 };
 
 }
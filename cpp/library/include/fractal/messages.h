@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 
 namespace Fractal
 {
@@ -89,6 +90,16 @@ struct Request_message
  
  Geo_message_header header;
  uint16_t max_iterations;
+
+ // Deep zoom requests give the complex view as offsets from a reference point whose coordinates are decimal strings
+ // of any precision, see Perturbation_function.
+ bool deep_zoom{false};
+ std::string reference_real{"0"};
+ std::string reference_imaginary{"0"};
+
+ // Samples per side of the grid pixels close to the boundary of the set are antialiased with, see
+ // Distance_estimation_function.  Zero or one renders a single sample per pixel.
+ uint16_t supersampling{0};
 };
 
 struct Response_message
@@ -99,6 +110,23 @@ struct Response_message
   std::vector<uint32_t> argb_buffer;
 };
 
+// Pixels left where they are, rows stride pixels apart.
+struct Argb_span
+{
+  const uint32_t* data{nullptr};
+  size_t width{0};
+  size_t height{0};
+  size_t stride{0};
+};
+
+// A response whose pixels are still those of the view they were rendered into (see Fractal_view::tile_span).  It is
+// written exactly like a Response_message and reads back as one, without the pixels being gathered first.
+struct Response_view
+{
+  Geo_message_header header;
+  Argb_span argb;
+};
+
 struct Cancel_message
 {
   static constexpr uint8_t ID = 2;
@@ -138,29 +166,43 @@ std::ostream& print(std::ostream& os, const Request_message& obj)
   os << "Request Message" << std::endl;
   print(os, obj.header);
   os << "Max Iterations: " << obj.max_iterations << std::endl;
+  if (obj.deep_zoom)
+  {
+    os << "Reference Real: " << obj.reference_real << std::endl;
+    os << "Reference Imaginary: " << obj.reference_imaginary << std::endl;
+  }
+  if (obj.supersampling > 1)
+  {
+    os << "Supersampling: " << obj.supersampling << std::endl;
+  }
   return os;
 }
 
-std::ostream& print(std::ostream& os, const uint32_t* buffer, size_t width, size_t height)
+std::ostream& print(std::ostream& os, const Argb_span& span)
 {
-  if (!buffer || width == 0 || height == 0)
+  if (!span.data || span.width == 0 || span.height == 0)
   {
     return os;
   }
   
-  os << "P3\n" << width << " " << height << " 255" << std::endl;
-  for (int64_t i = height - 1; i >= 0; --i)
+  os << "P3\n" << span.width << " " << span.height << " 255" << std::endl;
+  for (int64_t i = span.height - 1; i >= 0; --i)
   {
-    auto factor = i * width;
-    for (size_t j = 0; j < width; ++j)
+    auto factor = i * span.stride;
+    for (size_t j = 0; j < span.width; ++j)
     {
-      auto color = buffer[j + factor];
+      auto color = span.data[j + factor];
       os << ((color >> 16) & 0xFF) << " " << ((color >> 8) & 0xFF) << " " << (color & 0xFF) << "\n";
     }
   }
   return os;
 }
 
+std::ostream& print(std::ostream& os, const uint32_t* buffer, size_t width, size_t height)
+{
+  return print(os, Argb_span{buffer, width, height, width});
+}
+
 std::ostream& print(std::ostream& os, const std::shared_ptr<uint32_t>& buffer, size_t width, size_t height)
 {
   return print(os, buffer.get(), width, height);
@@ -184,6 +226,14 @@ std::ostream& print(std::ostream& os, const Response_message& obj)
   return os;
 }
 
+std::ostream& print(std::ostream& os, const Response_view& obj)
+{
+  os << "Response Message" << std::endl;
+  print(os, obj.header);
+  print(os, obj.argb);
+  return os;
+}
+
 std::ostream& print(std::ostream& os, const Cancel_message& obj)
 {
   os << "Cancel Message" << std::endl;
@@ -279,6 +329,26 @@ bool operator==(const Request_message& left, const Request_message& right)
   {
     return false;
   }
+
+  if (left.deep_zoom != right.deep_zoom)
+  {
+    return false;
+  }
+
+  if (left.reference_real != right.reference_real)
+  {
+    return false;
+  }
+
+  if (left.reference_imaginary != right.reference_imaginary)
+  {
+    return false;
+  }
+
+  if (left.supersampling != right.supersampling)
+  {
+    return false;
+  }
   
   return true;
 }
@@ -363,6 +433,14 @@ std::ostream& operator<<(std::ostream& os, const Request_message& obj)
   os << obj.header;
   os << obj.max_iterations;
   os << std::endl;
+  os << obj.deep_zoom;
+  os << std::endl;
+  os << obj.reference_real;
+  os << std::endl;
+  os << obj.reference_imaginary;
+  os << std::endl;
+  os << obj.supersampling;
+  os << std::endl;
   
   return os;
 }
@@ -381,6 +459,24 @@ std::ostream& operator<<(std::ostream& os, const Response_message& obj)
   return os;
 }
 
+std::ostream& operator<<(std::ostream& os, const Response_view& obj)
+{
+  const_cast<Response_view&>(obj).header.header.type = Response_message::ID;
+  os << obj.header;
+  
+  for (size_t y = 0; y < obj.argb.height; ++y)
+  {
+    const auto* row = obj.argb.data + y * obj.argb.stride;
+    for (size_t x = 0; x < obj.argb.width; ++x)
+    {
+      os << row[x];
+      os << std::endl;
+    }
+  }
+  
+  return os;
+}
+
 std::ostream& operator<<(std::ostream& os, const Cancel_message& obj)
 {
   const_cast<Cancel_message&>(obj).header.type = Cancel_message::ID;
@@ -417,10 +513,30 @@ std::istream& operator>>(std::istream& is, Geo_message_header& obj)
   return is;
 }
 
+// Reads a field added to the end of a message after it was first released.  A message in the older, shorter format
+// ends before the field, which then keeps the value it has and leaves the stream at its end rather than failed.
+template <typename T>
+std::istream& read_trailing_(std::istream& is, T& field)
+{
+  if (!is || is.eof() || (is >> std::ws).eof())
+  {
+    return is;
+  }
+  
+  is >> field;
+  return is;
+}
+
 std::istream& operator>>(std::istream& is, Request_message& obj)
 {
   is >> obj.header;
   is >> obj.max_iterations;
+  // Requests from before deep zoom end here.
+  read_trailing_(is, obj.deep_zoom);
+  read_trailing_(is, obj.reference_real);
+  read_trailing_(is, obj.reference_imaginary);
+  // And from before supersampling here.
+  read_trailing_(is, obj.supersampling);
   
   return is;
 }
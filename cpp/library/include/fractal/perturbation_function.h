@@ -0,0 +1,291 @@
+//
+//  perturbation_function.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef perturbation_function_h
+#define perturbation_function_h
+
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "colormap.h"
+#include "fixed_point.h"
+#include "fractal_view.h"
+#include "reference_orbit.h"
+
+namespace Fractal
+{
+
+// Deep zoom variant of Mandlebrot_function.  The coordinates it is given are offsets from a reference point known to
+// arbitrary precision, so the complex view of a deep zoom stays small enough for doubles.  The reference is iterated
+// once at high precision and every pixel iterates its delta from that orbit in double precision:
+//
+//   delta(n + 1) = 2 Z(n) delta(n) + delta(n)^2 + delta_c
+//
+// Pixels whose delta loses its precision (glitches) are detected and recomputed against a new reference taken from
+// among them.  The reference orbit is iterated by the first tile that needs it, on a worker of the render and under
+// its cancel token, rather than where the function is made.
+class Perturbation_function final
+{
+public:
+  Perturbation_function() = default;
+  Perturbation_function(const std::string& reference_real,
+                        const std::string& reference_imaginary,
+                        const Fractal_view& fractal_view,
+                        size_t max_iterations)
+  : m_max_iterations{max_iterations},
+    m_precision_bits{Reference_orbit::precision_bits(fractal_view.pixel_spacing())},
+    m_reference{std::make_shared<Reference_>(Fixed_point{reference_real, m_precision_bits},
+                                             Fixed_point{reference_imaginary, m_precision_bits})}
+  {
+  }
+  Perturbation_function(const Perturbation_function&) = default;
+  Perturbation_function(Perturbation_function&&) = default;
+  ~Perturbation_function() = default;
+
+  Perturbation_function& operator=(const Perturbation_function&) = default;
+  Perturbation_function& operator=(Perturbation_function&&) = default;
+
+  uint32_t invoke(std::complex<double> delta, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    auto result = iterate_(reference_(*cancel_token), delta, *cancel_token);
+    if (result.glitched)
+    {
+      // A single pixel has nothing to share a new reference with, so it becomes its own reference.
+      result = iterate_(reference_at_(delta, *cancel_token), std::complex<double>{}, *cancel_token);
+    }
+    return (*m_color_table)(result.iterations);
+  }
+
+  uint32_t operator()(std::complex<double> delta, const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    return invoke(std::move(delta), cancel_token);
+  }
+
+  // Evaluates a width x height tile, pixel (x, y) being the offset real[x] + imaginary[y] * i from the reference and
+  // landing in argb[x + y * stride].
+  void invoke_tile(const double* real,
+                   size_t width,
+                   const double* imaginary,
+                   size_t height,
+                   uint32_t* argb,
+                   size_t stride,
+                   const std::shared_ptr<std::atomic<bool>>& cancel_token) const
+  {
+    const auto& orbit = reference_(*cancel_token);
+
+    // A cancel leaves the rows after it as they were, the rows iterated so far are colored all the same.
+    auto rows = height;
+    auto glitched = std::vector<size_t>{};
+    for (size_t y = 0; y < height; ++y)
+    {
+      for (size_t x = 0; x < width; ++x)
+      {
+        auto delta = std::complex<double>{real[x], imaginary[y]};
+        auto result = iterate_(orbit, delta, *cancel_token);
+        argb[x + y * stride] = static_cast<uint32_t>(result.iterations);
+        if (result.glitched)
+        {
+          glitched.push_back(x + y * width);
+        }
+      }
+
+      if (cancel_token->load())
+      {
+        rows = y + 1;
+        break;
+      }
+    }
+
+    for (size_t reference = 0; reference < m_max_references && !glitched.empty() && !cancel_token->load(); ++reference)
+    {
+      auto index = pick_reference_(glitched, real, width, imaginary);
+      auto offset = std::complex<double>{real[index % width], imaginary[index / width]};
+      auto glitch_orbit = reference_at_(offset, *cancel_token);
+
+      auto remaining = std::vector<size_t>{};
+      for (auto pixel : glitched)
+      {
+        auto delta = std::complex<double>{real[pixel % width], imaginary[pixel / width]};
+        auto result = iterate_(glitch_orbit, delta - offset, *cancel_token);
+        argb[pixel % width + (pixel / width) * stride] = static_cast<uint32_t>(result.iterations);
+        if (result.glitched)
+        {
+          remaining.push_back(pixel);
+        }
+      }
+      glitched = std::move(remaining);
+    }
+
+    // Pixels still glitched after max_references, or when canceled, keep the iteration count they reached.
+    m_color_table->invoke_tile(argb, nullptr, width, rows, stride, argb, stride);
+  }
+
+  size_t max_iterations() const
+  {
+    return m_max_iterations;
+  }
+
+  const Colormap& colormap() const
+  {
+    return m_color_table->colormap();
+  }
+
+  void set_colormap(Colormap colormap)
+  {
+    m_color_table = std::make_shared<const Color_table>(std::move(colormap), m_max_iterations);
+  }
+
+  size_t precision_bits() const
+  {
+    return m_precision_bits;
+  }
+
+  // Iterated here if no tile has needed it yet.
+  const Reference_orbit& reference() const
+  {
+    std::atomic<bool> cancel_token{false};
+    return reference_(cancel_token);
+  }
+
+  size_t max_references() const
+  {
+    return m_max_references;
+  }
+
+  // Number of additional references a tile may compute to fix its glitched pixels.
+  void set_max_references(size_t max_references)
+  {
+    m_max_references = max_references;
+  }
+
+private:
+  struct Result_
+  {
+    size_t iterations;
+    bool glitched;
+  };
+
+  // Reference point shared by the copies of the function, its orbit iterated once by whichever needs it first.
+  struct Reference_
+  {
+    Reference_() = default;
+    Reference_(Fixed_point real_, Fixed_point imaginary_)
+    : real{std::move(real_)},
+      imaginary{std::move(imaginary_)}
+    {
+    }
+    Reference_(const Reference_&) = delete;
+    Reference_(Reference_&&) = delete;
+    ~Reference_() = default;
+
+    Reference_& operator=(const Reference_&) = delete;
+    Reference_& operator=(Reference_&&) = delete;
+
+    Fixed_point real;
+    Fixed_point imaginary;
+    std::once_flag iterated;
+    Reference_orbit orbit;
+  };
+
+  static constexpr size_t s_cancel_check_interval = 256;
+
+  // delta_c is the pixel's offset from the orbit's reference point.
+  Result_ iterate_(const Reference_orbit& orbit, std::complex<double> delta_c, const std::atomic<bool>& cancel_token) const
+  {
+    // The orbit starts at z = c, so the delta starts at delta_c.
+    auto delta = delta_c;
+    for (size_t i = 0; i < m_max_iterations; ++i)
+    {
+      if (i >= orbit.size())
+      {
+        // The reference escaped before this pixel did.
+        return Result_{i, true};
+      }
+
+      const auto& z_reference = orbit[i];
+      auto z = z_reference + delta;
+      auto magnitude = std::norm(z);
+      if (magnitude > 4)
+      {
+        return Result_{i, false};
+      }
+
+      if (magnitude < orbit.glitch_threshold(i))
+      {
+        return Result_{i, true};
+      }
+
+      delta = (z_reference + z_reference + delta) * delta + delta_c;
+
+      if (i % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+      {
+        return Result_{i, false};
+      }
+    }
+    return Result_{m_max_iterations, false};
+  }
+
+  // An orbit cut short by a cancel stays that way, the render it was iterated for is over.
+  const Reference_orbit& reference_(const std::atomic<bool>& cancel_token) const
+  {
+    auto& reference = *m_reference;
+    std::call_once(reference.iterated, [&]()
+    {
+      reference.orbit = Reference_orbit{reference.real, reference.imaginary, m_max_iterations, cancel_token};
+    });
+    return reference.orbit;
+  }
+
+  Reference_orbit reference_at_(std::complex<double> offset, const std::atomic<bool>& cancel_token) const
+  {
+    return Reference_orbit{m_reference->real + Fixed_point{offset.real(), m_precision_bits},
+                           m_reference->imaginary + Fixed_point{offset.imag(), m_precision_bits},
+                           m_max_iterations,
+                           cancel_token};
+  }
+
+  // The glitched pixel closest to the centroid of all of them, glitches tend to form blobs around a point whose
+  // orbit is the right reference for the whole blob.
+  static size_t pick_reference_(const std::vector<size_t>& glitched, const double* real, size_t width, const double* imaginary)
+  {
+    auto centroid = std::complex<double>{};
+    for (auto pixel : glitched)
+    {
+      centroid += std::complex<double>{real[pixel % width], imaginary[pixel / width]};
+    }
+    centroid /= static_cast<double>(glitched.size());
+
+    auto best = glitched.front();
+    auto best_distance = std::norm(std::complex<double>{real[best % width], imaginary[best / width]} - centroid);
+    for (auto pixel : glitched)
+    {
+      auto distance = std::norm(std::complex<double>{real[pixel % width], imaginary[pixel / width]} - centroid);
+      if (distance < best_distance)
+      {
+        best = pixel;
+        best_distance = distance;
+      }
+    }
+    return best;
+  }
+
+private:
+  size_t m_max_iterations{64};
+  std::shared_ptr<const Color_table> m_color_table{std::make_shared<const Color_table>(Colormap{}, m_max_iterations)};
+  size_t m_precision_bits{64};
+  size_t m_max_references{8};
+  std::shared_ptr<Reference_> m_reference{std::make_shared<Reference_>()};
+};
+
+}
+
+#endif /* perturbation_function_h */
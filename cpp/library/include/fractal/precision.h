@@ -0,0 +1,108 @@
+//
+//  precision.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef precision_h
+#define precision_h
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Fractal
+{
+
+// Number types a tile can be iterated with, from the cheapest to the most precise.
+enum class Precision : uint8_t
+{
+  float32,
+  float64,
+  double_double,
+  quad_double
+};
+
+inline const char* to_string(Precision precision)
+{
+  switch (precision)
+  {
+    case Precision::float32: return "float32";
+    case Precision::double_double: return "double_double";
+    case Precision::quad_double: return "quad_double";
+    default: return "float64";
+  }
+}
+
+// Bits of significand of each precision.
+inline size_t significand_bits(Precision precision)
+{
+  switch (precision)
+  {
+    case Precision::float32: return 24;
+    case Precision::double_double: return 106;
+    case Precision::quad_double: return 212;
+    default: return 53;
+  }
+}
+
+// Bits of significand it takes to separate pixels pixel_spacing apart at coordinates of magnitude up to magnitude,
+// log2(magnitude / pixel_spacing).  Infinite when the spacing is too small to tell.
+inline double resolution_bits(double pixel_spacing, double magnitude)
+{
+  if (!(pixel_spacing > 0))
+  {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  return std::log2(std::max(magnitude, pixel_spacing) / pixel_spacing);
+}
+
+// Cheapest precision that still tells neighbouring pixels apart after max_iterations iterations.  On top of the
+// resolution_bits of the pixels, each iteration adds rounding error that the next ones can magnify, which costs
+// about log2(max_iterations) more bits plus a fixed guard.
+inline Precision select_precision(double resolution_bits, size_t max_iterations)
+{
+  static constexpr double guard_bits = 12.0;
+
+  auto bits = resolution_bits + guard_bits + std::ceil(std::log2(static_cast<double>(std::max(max_iterations, size_t{1}))));
+  for (auto precision : {Precision::float32, Precision::float64, Precision::double_double})
+  {
+    if (bits <= static_cast<double>(significand_bits(precision)))
+    {
+      return precision;
+    }
+  }
+  return Precision::quad_double;
+}
+
+// Number of tiles, and of the pixels they cover, computed at each precision.
+struct Precision_statistics
+{
+  std::atomic<uint64_t> tiles[4] = {};
+  std::atomic<uint64_t> pixels[4] = {};
+
+  void record(Precision precision, uint64_t pixel_count)
+  {
+    ++tiles[static_cast<size_t>(precision)];
+    pixels[static_cast<size_t>(precision)] += pixel_count;
+  }
+
+  void reset()
+  {
+    for (size_t i = 0; i < 4; ++i)
+    {
+      tiles[i] = 0;
+      pixels[i] = 0;
+    }
+  }
+};
+
+}
+
+#endif /* precision_h */
@@ -0,0 +1,132 @@
+//
+//  reference_orbit.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef reference_orbit_h
+#define reference_orbit_h
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "fixed_point.h"
+
+namespace Fractal
+{
+
+// Orbit of a single point iterated at high precision and stored as doubles, which is all the precision the pixels
+// perturbed around it need.  Follows the same convention as Mandlebrot_function, the orbit starts at z = c.
+class Reference_orbit final
+{
+public:
+  Reference_orbit() = default;
+  Reference_orbit(Fixed_point real, Fixed_point imaginary, size_t max_iterations)
+  : m_real{std::move(real)},
+    m_imaginary{std::move(imaginary)}
+  {
+    std::atomic<bool> cancel_token{false};
+    compute_(max_iterations, cancel_token);
+  }
+  Reference_orbit(Fixed_point real, Fixed_point imaginary, size_t max_iterations, const std::atomic<bool>& cancel_token)
+  : m_real{std::move(real)},
+    m_imaginary{std::move(imaginary)}
+  {
+    compute_(max_iterations, cancel_token);
+  }
+  Reference_orbit(const Reference_orbit&) = default;
+  Reference_orbit(Reference_orbit&&) = default;
+  ~Reference_orbit() = default;
+
+  Reference_orbit& operator=(const Reference_orbit&) = default;
+  Reference_orbit& operator=(Reference_orbit&&) = default;
+
+  // Number of points in the orbit.  Shorter than max_iterations when the reference escaped, in which case the last
+  // point is the first one outside of the escape radius.
+  size_t size() const
+  {
+    return m_orbit.size();
+  }
+
+  const std::complex<double>& operator[](size_t i) const
+  {
+    return m_orbit[i];
+  }
+
+  // |Z|^2 scaled by the glitch tolerance, precomputed for every point of the orbit.
+  double glitch_threshold(size_t i) const
+  {
+    return m_glitch_thresholds[i];
+  }
+
+  const Fixed_point& real() const
+  {
+    return m_real;
+  }
+
+  const Fixed_point& imaginary() const
+  {
+    return m_imaginary;
+  }
+
+  // Bits of precision needed to resolve individual pixels pixel_spacing apart, with a margin for the error the
+  // orbit accumulates.
+  static size_t precision_bits(double pixel_spacing)
+  {
+    auto bits = pixel_spacing > 0 ? std::max(0.0, std::ceil(-std::log2(pixel_spacing))) : 0.0;
+    return static_cast<size_t>(bits) + s_guard_bits;
+  }
+
+private:
+  static constexpr size_t s_guard_bits = 64;
+  static constexpr size_t s_cancel_check_interval = 256;
+  // Pauldelbrot's criterion, a pixel whose |z|^2 drops below this fraction of the reference's |Z|^2 has lost the
+  // precision of its delta.
+  static constexpr double s_glitch_tolerance = 1e-6;
+
+  void compute_(size_t max_iterations, const std::atomic<bool>& cancel_token)
+  {
+    m_orbit.reserve(max_iterations);
+    m_glitch_thresholds.reserve(max_iterations);
+
+    auto z_real = m_real;
+    auto z_imaginary = m_imaginary;
+    for (size_t i = 0; i < max_iterations; ++i)
+    {
+      auto z = std::complex<double>{z_real.to_double(), z_imaginary.to_double()};
+      m_orbit.push_back(z);
+      m_glitch_thresholds.push_back(s_glitch_tolerance * std::norm(z));
+
+      if (std::norm(z) > 4)
+      {
+        break;
+      }
+
+      auto real_squared = z_real * z_real;
+      auto imaginary_squared = z_imaginary * z_imaginary;
+      auto product = z_real * z_imaginary;
+      z_imaginary = product + product + m_imaginary;
+      z_real = real_squared - imaginary_squared + m_real;
+
+      if (i % s_cancel_check_interval == 0 && cancel_token.load(std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+  }
+
+private:
+  Fixed_point m_real;
+  Fixed_point m_imaginary;
+  std::vector<std::complex<double>> m_orbit;
+  std::vector<double> m_glitch_thresholds;
+};
+
+}
+
+#endif /* reference_orbit_h */
@@ -0,0 +1,330 @@
+//
+//  render_handle.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef render_handle_h
+#define render_handle_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "cost_map.h"
+#include "task_parameters.h"
+#include "work_stealing_pool.h"
+
+namespace Fractal
+{
+
+// Runs the callbacks of a render where the caller wants them, a GUI event loop or an I/O thread for instance.  An
+// empty executor runs them right away on the worker that finished the tile.
+using Executor = std::function<void(std::function<void()>)>;
+
+// State of one submitted render, shared by its tasks and the handles to it.
+class Render_job final
+{
+public:
+  Render_job() = default;
+  Render_job(Executor executor)
+  : m_executor{std::move(executor)}
+  {
+  }
+  Render_job(const Render_job&) = delete;
+  Render_job(Render_job&&) = delete;
+  ~Render_job() = default;
+
+  Render_job& operator=(const Render_job&) = delete;
+  Render_job& operator=(Render_job&&) = delete;
+
+  Task_group& tasks()
+  {
+    return m_tasks;
+  }
+
+  // Called once per task of the job, the last one runs the continuations.
+  void done()
+  {
+    if (m_tasks.done())
+    {
+      finish_();
+    }
+  }
+
+  // Counts the tile and hooks its callbacks so they report the tile done and run on the executor.  Called for every
+  // tile before any task is pushed.
+  void add_tile(Generator_task_parameters& tp)
+  {
+    add_tiles(tp, 1);
+  }
+
+  // The same for count tiles sharing the parameters of tp, the prototype of a Tile_range.
+  void add_tiles(Generator_task_parameters& tp, size_t count)
+  {
+    m_tile_count += count;
+    if (std::find(m_cancel_tokens.begin(), m_cancel_tokens.end(), tp.cancel_token) == m_cancel_tokens.end())
+    {
+      m_cancel_tokens.emplace_back(tp.cancel_token);
+    }
+
+    tp.on_task_completed = callback_(std::move(tp.on_task_completed));
+    tp.on_task_canceled = callback_(std::move(tp.on_task_canceled));
+  }
+
+  size_t tile_count() const
+  {
+    return m_tile_count;
+  }
+
+  size_t completed_tile_count() const
+  {
+    return m_completed_tile_count.load();
+  }
+
+  void add_evaluated_pixels(size_t count)
+  {
+    m_evaluated_pixel_count += count;
+  }
+
+  size_t evaluated_pixel_count() const
+  {
+    return m_evaluated_pixel_count.load();
+  }
+
+  // Where the tasks of the job record how long they took, may be null.
+  const std::shared_ptr<Cost_map>& cost_map() const
+  {
+    return m_cost_map;
+  }
+
+  void set_cost_map(std::shared_ptr<Cost_map> cost_map)
+  {
+    m_cost_map = std::move(cost_map);
+  }
+
+  void cancel()
+  {
+    for (const auto& cancel_token : m_cancel_tokens)
+    {
+      cancel_token->store(true);
+    }
+  }
+
+  // Finished once the continuations have run, or have been handed to the executor.
+  bool finished() const
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_finished;
+  }
+
+  void wait() const
+  {
+    auto lock = std::unique_lock<std::mutex>{m_mutex};
+    m_finished_condition.wait(lock, [&]()
+    {
+      return m_finished;
+    });
+  }
+
+  template <typename Rep, typename Period>
+  bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const
+  {
+    auto lock = std::unique_lock<std::mutex>{m_mutex};
+    return m_finished_condition.wait_for(lock, timeout, [&]()
+    {
+      return m_finished;
+    });
+  }
+
+  void then(std::function<void()> continuation)
+  {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      if (!m_finished)
+      {
+        m_continuations.emplace_back(std::move(continuation));
+        return;
+      }
+    }
+    execute_(std::move(continuation));
+  }
+
+private:
+  std::function<void(const Task_parameters&)> callback_(std::function<void(const Task_parameters&)> callback)
+  {
+    return [this, callback = std::move(callback)](const Task_parameters& parameters)
+    {
+      ++m_completed_tile_count;
+      if (!callback)
+      {
+        return;
+      }
+
+      if (!m_executor)
+      {
+        callback(parameters);
+        return;
+      }
+
+      // The tile is passed by reference on the worker, the executor gets a copy of its own.
+      m_executor([callback, tp = static_cast<const Generator_task_parameters&>(parameters)]()
+      {
+        callback(tp);
+      });
+    };
+  }
+
+  // Continuations added while the others run are picked up on the next round.
+  void finish_()
+  {
+    while (true)
+    {
+      auto continuations = std::vector<std::function<void()>>{};
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_continuations.empty())
+        {
+          m_finished = true;
+          m_finished_condition.notify_all();
+          return;
+        }
+        continuations.swap(m_continuations);
+      }
+
+      for (auto& continuation : continuations)
+      {
+        execute_(std::move(continuation));
+      }
+    }
+  }
+
+  void execute_(std::function<void()> continuation)
+  {
+    if (m_executor)
+    {
+      m_executor(std::move(continuation));
+    }
+    else
+    {
+      continuation();
+    }
+  }
+
+private:
+  Executor m_executor;
+  std::shared_ptr<Cost_map> m_cost_map;
+  Task_group m_tasks;
+  size_t m_tile_count{0};
+  std::atomic<size_t> m_completed_tile_count{0};
+  std::atomic<size_t> m_evaluated_pixel_count{0};
+  std::vector<std::shared_ptr<std::atomic<bool>>> m_cancel_tokens;
+  mutable std::mutex m_mutex;
+  mutable std::condition_variable m_finished_condition;
+  bool m_finished{false};
+  std::vector<std::function<void()>> m_continuations;
+};
+
+// Handle to a render Distributed_generator::submit started.  Copies refer to the same render, destroying them
+// doesn't stop it.
+class Render_handle final
+{
+public:
+  Render_handle() = default;
+  Render_handle(std::shared_ptr<Render_job> job)
+  : m_job{std::move(job)}
+  {
+  }
+  Render_handle(const Render_handle&) = default;
+  Render_handle(Render_handle&&) = default;
+  ~Render_handle() = default;
+
+  Render_handle& operator=(const Render_handle&) = default;
+  Render_handle& operator=(Render_handle&&) = default;
+
+  // Handles are equal when they refer to the same render.
+  bool operator==(const Render_handle& other) const
+  {
+    return m_job == other.m_job;
+  }
+
+  bool operator!=(const Render_handle& other) const
+  {
+    return !(*this == other);
+  }
+
+  bool valid() const
+  {
+    return m_job != nullptr;
+  }
+
+  // Blocks until every tile of the render is completed or canceled and the continuations added so far have run.
+  void wait() const
+  {
+    m_job->wait();
+  }
+
+  // Returns whether the render finished within the timeout.
+  template <typename Rep, typename Period>
+  bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const
+  {
+    return m_job->wait_for(timeout);
+  }
+
+  bool finished() const
+  {
+    return m_job->finished();
+  }
+
+  // Fraction of the tiles completed or canceled so far.
+  double progress() const
+  {
+    auto tile_count = m_job->tile_count();
+    return tile_count == 0 ? 1.0 : static_cast<double>(m_job->completed_tile_count()) / static_cast<double>(tile_count);
+  }
+
+  size_t tile_count() const
+  {
+    return m_job->tile_count();
+  }
+
+  size_t completed_tile_count() const
+  {
+    return m_job->completed_tile_count();
+  }
+
+  // Pixels the function was evaluated for so far, the others were filled by subdivision or tracing.
+  size_t evaluated_pixel_count() const
+  {
+    return m_job->evaluated_pixel_count();
+  }
+
+  // Sets the cancel tokens of the tiles, the tiles not yet done report through on_task_canceled.
+  void cancel() const
+  {
+    m_job->cancel();
+  }
+
+  // Runs the continuation on the executor of the render once it finished, right away when it already has.
+  // Continuations run in the order they were added.
+  const Render_handle& then(std::function<void()> continuation) const
+  {
+    m_job->then(std::move(continuation));
+    return *this;
+  }
+
+private:
+  std::shared_ptr<Render_job> m_job;
+};
+
+}
+
+#endif /* render_handle_h */
@@ -0,0 +1,30 @@
+//
+//  symmetry.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef symmetry_h
+#define symmetry_h
+
+#include <cstdint>
+
+namespace Fractal
+{
+
+// Symmetry of the image a function renders, which Generator_task_parameters::distribute uses to evaluate only one
+// side of a view straddling it.
+enum class Symmetry : uint8_t
+{
+  none,
+  // f(conj(c)) == f(c), the Mandlebrot set and the other sets of polynomials with real coefficients.
+  real_axis,
+  // f(-z) == f(z), every Julia set of z^2 + k.
+  origin
+};
+
+}
+
+#endif /* symmetry_h */
@@ -9,13 +9,23 @@
 #ifndef task_h
 #define task_h
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <utility>
+#include <vector>
 
+#include "cost_map.h"
 #include "fractal_view.h"
+#include "precision.h"
+#include "symmetry.h"
 
 namespace Fractal
 {
+class Tile_range;
+
 struct Task_parameters
 {
   std::string identifier;
@@ -24,12 +34,41 @@ struct Task_parameters
   std::function<void(const Task_parameters&)> on_task_canceled;
 };
 
+// Order the tiles of a view are rendered in: as distribute cut them, out from the centre of the view, out from a focus
+// point such as the cursor, or along a Hilbert or Morton (Z-order) curve so tiles next to each other finish close
+// together in time, and a run of the order handed to one worker (see Tile_assignment) covers a compact patch of the
+// view.
+enum class Tile_order
+{
+  distributed,
+  centre_out,
+  focus,
+  hilbert,
+  morton
+};
+
 struct Generator_task_parameters : Task_parameters
 {
   Fractal_view fractal_view;
   Fractal_view::Pixel_view pixel_tile_view;
   Fractal_view::Complex_view complex_tile_view;
+  // Bits of significand that separate the pixels of the tile (see resolution_bits).  Functions that support several
+  // precisions are set to the cheapest that is enough for these and their iterations (see select_precision).
+  double resolution_bits{0.0};
+  // The precision picked for the tile, set by Distributed_generator just before the tile is rendered, so completion
+  // callbacks see what each tile ran in.  Left at float64 for functions with a single precision.
+  Precision precision{Precision::float64};
+  // Set when the view straddles the symmetry of the function, once the tile is evaluated its pixels in
+  // mirror_source_view are copied to their images in mirror_target_view.
+  Symmetry symmetry{Symmetry::none};
+  Fractal_view::Pixel_view mirror_source_view{};
+  Fractal_view::Pixel_view mirror_target_view{};
+  // Tiles of higher priority are started first (see order).
+  int priority{0};
   
+  // Given the symmetry of the function, the tiles leave out the part of the view that is the image of another part
+  // and the tiles covering that other part mirror it.  The tiles go down the columns of the grid one after the other
+  // unless another tile order is given (see order).
   template <typename Completed_callback, typename Canceled_callback>
   static std::vector<Generator_task_parameters> distribute(std::string task_identifier,
                                                            std::shared_ptr<std::atomic<bool>> cancel_token,
@@ -37,7 +76,9 @@ struct Generator_task_parameters : Task_parameters
                                                            Canceled_callback on_task_canceled,	
                                                            Fractal_view view,
                                                            size_t tile_width,
-                                                           size_t tile_height)
+                                                           size_t tile_height,
+                                                           Symmetry symmetry = Symmetry::none,
+                                                           Tile_order tile_order = Tile_order::distributed)
   {
     auto tasks = std::vector<Generator_task_parameters>{};
     
@@ -48,11 +89,12 @@ struct Generator_task_parameters : Task_parameters
       task.fractal_view = view;
       task.pixel_tile_view = view.pixel_view();
       task.complex_tile_view = view.complex_view();
+      task.resolution_bits = resolution_bits_(view, task.complex_tile_view);
       task.identifier = task_identifier;
       task.cancel_token = cancel_token;
       task.on_task_completed = on_task_completed;
       task.on_task_canceled = on_task_canceled;
-      return tasks;
+      return symmetric_(std::move(tasks), view, symmetry);
     }
   
     auto rows = view.pixel_view().height() / tile_height;
@@ -90,6 +132,7 @@ struct Generator_task_parameters : Task_parameters
         task.fractal_view = view;
         task.pixel_tile_view = pixel_view;
         task.complex_tile_view = complex_view;
+        task.resolution_bits = resolution_bits_(view, complex_view);
         task.identifier = task_identifier;
         task.cancel_token = cancel_token;
         task.on_task_completed = on_task_completed;
@@ -97,8 +140,479 @@ struct Generator_task_parameters : Task_parameters
       }
     }
     
+    tasks = symmetric_(std::move(tasks), view, symmetry);
+    if (tile_order != Tile_order::distributed)
+    {
+      order(tasks, tile_order);
+    }
     return tasks;
   }
+
+  // Cuts the view into task_count tiles of about the same estimated cost: the most expensive tile is split in two at
+  // the point that halves its cost until there are enough, so expensive regions end up in small tiles and cheap ones
+  // in large tiles, and no tile holds up the end of the render on its own.  The tiles come most expensive first.  An
+  // empty map, or one estimating nothing, splits the view by area.
+  template <typename Completed_callback, typename Canceled_callback>
+  static std::vector<Generator_task_parameters> distribute(std::string task_identifier,
+                                                           std::shared_ptr<std::atomic<bool>> cancel_token,
+                                                           Completed_callback on_task_completed,
+                                                           Canceled_callback on_task_canceled,
+                                                           Fractal_view view,
+                                                           const Cost_map& costs,
+                                                           size_t task_count,
+                                                           Symmetry symmetry = Symmetry::none)
+  {
+    // The mirrored part of the view costs nothing, it is copied rather than evaluated.
+    auto mirrored = Fractal_view::Pixel_view{};
+    auto row_sum = size_t{0};
+    auto column_sum = size_t{0};
+    if (!mirrored_view_(view, symmetry, mirrored, row_sum, column_sum))
+    {
+      mirrored = Fractal_view::Pixel_view{0, 0, 0, 0};
+    }
+
+    auto tiles = std::vector<Fractal_view::Pixel_view>{};
+    plan_(view, costs, mirrored, std::max(task_count, size_t{1}), tiles);
+
+    auto tasks = std::vector<Generator_task_parameters>{};
+    tasks.reserve(tiles.size());
+    for (const auto& tile : tiles)
+    {
+      tasks.emplace_back();
+      auto& task = tasks.back();
+      task.fractal_view = view;
+      task.pixel_tile_view = tile;
+      task.complex_tile_view = complex_view_(view, tile);
+      task.resolution_bits = resolution_bits_(view, task.complex_tile_view);
+      task.identifier = task_identifier;
+      task.cancel_token = cancel_token;
+      task.on_task_completed = on_task_completed;
+      task.on_task_canceled = on_task_canceled;
+    }
+
+    return symmetric_(std::move(tasks), view, symmetry);
+  }
+
+  // Orders the tiles and gives them priorities that fall along that order, so the pool starts the tiles first in the
+  // order first even with other renders queued.  The focus is in pixels of the view and only used by Tile_order::focus.
+  static void order(std::vector<Generator_task_parameters>& tasks, Tile_order tile_order, size_t focus_x = 0, size_t focus_y = 0)
+  {
+    order(tasks, [&](const Generator_task_parameters& task)
+    {
+      return rank_(tile_order, task.fractal_view.pixel_view(), task.pixel_tile_view, focus_x, focus_y);
+    });
+  }
+
+  // Orders the tiles by rank(tile), lowest first, keeping the order of tiles of the same rank.
+  template <typename Rank>
+  static void order(std::vector<Generator_task_parameters>& tasks, Rank rank)
+  {
+    using Ranked = std::pair<double, size_t>;
+    auto ranks = std::vector<Ranked>{};
+    ranks.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+      ranks.emplace_back(rank(static_cast<const Generator_task_parameters&>(tasks[i])), i);
+    }
+    std::sort(ranks.begin(), ranks.end());
+
+    auto ordered = std::vector<Generator_task_parameters>{};
+    ordered.reserve(tasks.size());
+    for (const auto& ranked : ranks)
+    {
+      ordered.emplace_back(std::move(tasks[ranked.second]));
+      ordered.back().priority = static_cast<int>(ranks.size() - ordered.size());
+    }
+    tasks.swap(ordered);
+  }
+
+private:
+  friend class Tile_range;
+
+  static double rank_(Tile_order tile_order,
+                      const Fractal_view::Pixel_view& pixels,
+                      const Fractal_view::Pixel_view& tile,
+                      size_t focus_x,
+                      size_t focus_y)
+  {
+    switch (tile_order)
+    {
+      case Tile_order::centre_out:
+        return spiral_(tile, 0.5 * static_cast<double>(pixels.left + pixels.right), 0.5 * static_cast<double>(pixels.top + pixels.bottom));
+      case Tile_order::focus:
+        return spiral_(tile, static_cast<double>(focus_x), static_cast<double>(focus_y));
+      case Tile_order::hilbert:
+        return hilbert_(pixels, tile);
+      case Tile_order::morton:
+        return morton_(pixels, tile);
+      default:
+        return 0.0;
+    }
+  }
+
+  // Rank of a tile spiralling out from (x, y): the tile holding the point, then by the distance of their centres and
+  // by the angle, so tiles about as far out go round in turn rather than jumping across the view.
+  static double spiral_(const Fractal_view::Pixel_view& tile, double x, double y)
+  {
+    if (x >= static_cast<double>(tile.left) && x < static_cast<double>(tile.right)
+        && y >= static_cast<double>(tile.top) && y < static_cast<double>(tile.bottom))
+    {
+      return -1.0;
+    }
+
+    auto dx = 0.5 * static_cast<double>(tile.left + tile.right) - x;
+    auto dy = 0.5 * static_cast<double>(tile.top + tile.bottom) - y;
+    // Rings as wide as the tile, the angle as a fraction within its ring.
+    auto ring = std::floor(std::hypot(dx, dy) / static_cast<double>(std::max(std::max(tile.width(), tile.height()), size_t{1})));
+    static const auto pi = std::acos(-1.0);
+    auto angle = (std::atan2(dy, dx) + pi) / (2.0 * pi);
+    return ring + std::min(angle, 0.999);
+  }
+
+  // Side of the grid the space filling curves go through.
+  static constexpr uint32_t s_curve_side = 1u << 16;
+
+  // Cell of the curve grid over the view the centre of the tile is in.
+  static std::pair<uint32_t, uint32_t> curve_cell_(const Fractal_view::Pixel_view& pixels, const Fractal_view::Pixel_view& tile)
+  {
+    auto cell = [&](size_t centre_twice, size_t start, size_t length)
+    {
+      auto offset = 0.5 * static_cast<double>(centre_twice) - static_cast<double>(start);
+      auto scaled = offset / static_cast<double>(std::max(length, size_t{1})) * s_curve_side;
+      return static_cast<uint32_t>(std::min(std::max(scaled, 0.0), static_cast<double>(s_curve_side - 1)));
+    };
+    return std::make_pair(cell(tile.left + tile.right, pixels.left, pixels.width()),
+                          cell(tile.top + tile.bottom, pixels.top, pixels.height()));
+  }
+
+  // Index along the Hilbert curve of the cell of the tile.
+  static double hilbert_(const Fractal_view::Pixel_view& pixels, const Fractal_view::Pixel_view& tile)
+  {
+    constexpr auto side = s_curve_side;
+    auto cell = curve_cell_(pixels, tile);
+    auto x = cell.first;
+    auto y = cell.second;
+
+    auto index = uint64_t{0};
+    for (auto s = side / 2; s > 0; s /= 2)
+    {
+      auto rx = (x & s) != 0 ? 1u : 0u;
+      auto ry = (y & s) != 0 ? 1u : 0u;
+      index += uint64_t{s} * s * ((3 * rx) ^ ry);
+      if (ry == 0)
+      {
+        if (rx == 1)
+        {
+          x = side - 1 - x;
+          y = side - 1 - y;
+        }
+        std::swap(x, y);
+      }
+    }
+    return static_cast<double>(index);
+  }
+
+  // Index along the Morton curve of the cell of the tile: the bits of x and y interleaved, x in the even bits.
+  static double morton_(const Fractal_view::Pixel_view& pixels, const Fractal_view::Pixel_view& tile)
+  {
+    auto spread = [](uint64_t bits)
+    {
+      bits = (bits | (bits << 8)) & 0x00ff00ffu;
+      bits = (bits | (bits << 4)) & 0x0f0f0f0fu;
+      bits = (bits | (bits << 2)) & 0x33333333u;
+      bits = (bits | (bits << 1)) & 0x55555555u;
+      return bits;
+    };
+    auto cell = curve_cell_(pixels, tile);
+    return static_cast<double>(spread(cell.first) | (spread(cell.second) << 1));
+  }
+
+  // Planned tiles are not split below this many pixels a side.
+  static constexpr size_t s_minimum_tile_size = 16;
+
+  // Splits the most expensive tile until there are task_count of them, then orders them most expensive first so the
+  // cheap ones fill in at the end.
+  static void plan_(const Fractal_view& view,
+                    const Cost_map& costs,
+                    const Fractal_view::Pixel_view& mirrored,
+                    size_t task_count,
+                    std::vector<Fractal_view::Pixel_view>& tiles)
+  {
+    const auto& pixels = view.pixel_view();
+    if (pixels.width() == 0 || pixels.height() == 0)
+    {
+      return;
+    }
+
+    auto by_area = !(costs.cost(view, pixels) > 0.0);
+    auto estimate = [&](const Fractal_view::Pixel_view& tile)
+    {
+      if (tile.left >= tile.right || tile.top >= tile.bottom)
+      {
+        return 0.0;
+      }
+      return by_area ? static_cast<double>(tile.width() * tile.height()) : costs.cost(view, tile);
+    };
+    auto cost = [&](const Fractal_view::Pixel_view& tile)
+    {
+      auto overlap = Fractal_view::Pixel_view{std::max(tile.left, mirrored.left),
+                                              std::max(tile.top, mirrored.top),
+                                              std::min(tile.right, mirrored.right),
+                                              std::min(tile.bottom, mirrored.bottom)};
+      return std::max(estimate(tile) - estimate(overlap), 0.0);
+    };
+
+    using Tile = std::pair<double, Fractal_view::Pixel_view>;
+    auto cheaper = [](const Tile& a, const Tile& b)
+    {
+      return a.first < b.first;
+    };
+    // Tiles that may still be split, as a heap on their cost, and tiles too small to be.
+    auto heap = std::vector<Tile>{{cost(pixels), pixels}};
+    auto done = std::vector<Tile>{};
+    while (!heap.empty() && heap.size() + done.size() < task_count)
+    {
+      std::pop_heap(heap.begin(), heap.end(), cheaper);
+      auto tile = heap.back().second;
+      auto tile_cost = heap.back().first;
+      heap.pop_back();
+
+      auto wide = tile.width() >= 2 * s_minimum_tile_size;
+      auto tall = tile.height() >= 2 * s_minimum_tile_size;
+      if (!wide && !tall)
+      {
+        done.emplace_back(tile_cost, tile);
+        continue;
+      }
+
+      // Across the longer side, the first cut whose first part costs at least half the tile.
+      auto vertical = wide && (tile.width() >= tile.height() || !tall);
+      auto start = (vertical ? tile.left : tile.top) + s_minimum_tile_size;
+      auto end = (vertical ? tile.right : tile.bottom) - s_minimum_tile_size;
+      auto first_part = [&](size_t cut)
+      {
+        auto first = tile;
+        (vertical ? first.right : first.bottom) = cut;
+        return first;
+      };
+      while (start < end)
+      {
+        auto middle = start + (end - start) / 2;
+        if (cost(first_part(middle)) < 0.5 * tile_cost)
+        {
+          start = middle + 1;
+        }
+        else
+        {
+          end = middle;
+        }
+      }
+
+      auto first = first_part(start);
+      auto second = tile;
+      (vertical ? second.left : second.top) = start;
+      for (const auto& part : {first, second})
+      {
+        heap.emplace_back(cost(part), part);
+        std::push_heap(heap.begin(), heap.end(), cheaper);
+      }
+    }
+
+    done.insert(done.end(), heap.begin(), heap.end());
+    std::sort(done.begin(), done.end(), [&](const Tile& a, const Tile& b)
+    {
+      return cheaper(b, a);
+    });
+    for (const auto& tile : done)
+    {
+      tiles.push_back(tile.second);
+    }
+  }
+
+  // Fraction of a pixel the axis or origin may be off the pixel grid for the view to be rendered symmetrically.
+  static constexpr double s_symmetry_tolerance = 1e-3;
+
+  static std::vector<Generator_task_parameters> symmetric_(std::vector<Generator_task_parameters> tasks,
+                                                           const Fractal_view& view,
+                                                           Symmetry symmetry)
+  {
+    auto mirrored = Fractal_view::Pixel_view{};
+    auto row_sum = size_t{0};
+    auto column_sum = size_t{0};
+    if (!mirrored_view_(view, symmetry, mirrored, row_sum, column_sum))
+    {
+      return tasks;
+    }
+
+    auto source = mirror_(mirrored, symmetry, row_sum, column_sum);
+    auto symmetric_tasks = std::vector<Generator_task_parameters>{};
+    for (const auto& task : tasks)
+    {
+      for (const auto& piece : subtract_(task.pixel_tile_view, mirrored))
+      {
+        symmetric_tasks.push_back(task);
+        auto& symmetric_task = symmetric_tasks.back();
+        symmetric_task.pixel_tile_view = piece;
+        symmetric_task.complex_tile_view = complex_view_(view, piece);
+        symmetric_task.resolution_bits = resolution_bits_(view, symmetric_task.complex_tile_view);
+
+        auto overlap = Fractal_view::Pixel_view{std::max(piece.left, source.left),
+                                                std::max(piece.top, source.top),
+                                                std::min(piece.right, source.right),
+                                                std::min(piece.bottom, source.bottom)};
+        if (overlap.left < overlap.right && overlap.top < overlap.bottom)
+        {
+          symmetric_task.symmetry = symmetry;
+          symmetric_task.mirror_source_view = overlap;
+          symmetric_task.mirror_target_view = mirror_(overlap, symmetry, row_sum, column_sum);
+        }
+      }
+    }
+
+    return symmetric_tasks;
+  }
+
+  // Pixels of the view that are the image of other pixels of the view, on the side of the axis (or of the origin)
+  // with fewer rows.  Pixels (x, y) and (column_sum - x, row_sum - y) are images of each other through the origin,
+  // (x, y) and (x, row_sum - y) across the real axis.
+  static bool mirrored_view_(const Fractal_view& view,
+                             Symmetry symmetry,
+                             Fractal_view::Pixel_view& mirrored,
+                             size_t& row_sum,
+                             size_t& column_sum)
+  {
+    const auto& pixels = view.pixel_view();
+    const auto& complex = view.complex_view();
+    if (symmetry == Symmetry::none || pixels.width() == 0 || pixels.height() == 0)
+    {
+      return false;
+    }
+
+    if (!pixel_sum_(complex.top, complex.height() / static_cast<double>(pixels.height()), row_sum))
+    {
+      return false;
+    }
+
+    auto first_row = row_sum / 2 + 1;
+    auto last_row = std::min(row_sum, pixels.height() - 1);
+    if (first_row > last_row)
+    {
+      return false;
+    }
+
+    mirrored = Fractal_view::Pixel_view{pixels.left, pixels.top + first_row, pixels.right, pixels.top + last_row + 1};
+    row_sum += 2 * pixels.top;
+
+    if (symmetry == Symmetry::origin)
+    {
+      if (!pixel_sum_(complex.left, complex.width() / static_cast<double>(pixels.width()), column_sum))
+      {
+        return false;
+      }
+
+      auto first_column = column_sum >= pixels.width() ? column_sum - (pixels.width() - 1) : 0;
+      auto last_column = std::min(column_sum, pixels.width() - 1);
+      if (first_column > last_column)
+      {
+        return false;
+      }
+
+      mirrored.left = pixels.left + first_column;
+      mirrored.right = pixels.left + last_column + 1;
+      column_sum += 2 * pixels.left;
+    }
+
+    return true;
+  }
+
+  // Pixel i lies at start + i * spacing, the pixels mirrored through zero are those whose indices add up to sum.
+  // False when zero is neither on a pixel nor half way between two.
+  static bool pixel_sum_(double start, double spacing, size_t& sum)
+  {
+    if (!(spacing > 0.0))
+    {
+      return false;
+    }
+
+    auto exact = -2.0 * start / spacing;
+    auto rounded = std::round(exact);
+    if (!(rounded >= 0.0) || std::fabs(exact - rounded) > s_symmetry_tolerance)
+    {
+      return false;
+    }
+
+    sum = static_cast<size_t>(rounded);
+    return true;
+  }
+
+  static Fractal_view::Pixel_view mirror_(const Fractal_view::Pixel_view& pixels, Symmetry symmetry, size_t row_sum, size_t column_sum)
+  {
+    auto image = Fractal_view::Pixel_view{pixels.left, row_sum + 1 - pixels.bottom, pixels.right, row_sum + 1 - pixels.top};
+    if (symmetry == Symmetry::origin)
+    {
+      image.left = column_sum + 1 - pixels.right;
+      image.right = column_sum + 1 - pixels.left;
+    }
+    return image;
+  }
+
+  static std::vector<Fractal_view::Pixel_view> subtract_(const Fractal_view::Pixel_view& tile, const Fractal_view::Pixel_view& hole)
+  {
+    Fractal_view::Pixel_view pieces[4];
+    auto count = subtract_(tile, hole, pieces);
+    return std::vector<Fractal_view::Pixel_view>(pieces, pieces + count);
+  }
+
+  // The parts of tile outside hole, at most four rectangles.  Returns how many.
+  static size_t subtract_(const Fractal_view::Pixel_view& tile, const Fractal_view::Pixel_view& hole, Fractal_view::Pixel_view (&pieces)[4])
+  {
+    auto top = std::max(tile.top, hole.top);
+    auto bottom = std::min(tile.bottom, hole.bottom);
+    auto left = std::max(tile.left, hole.left);
+    auto right = std::min(tile.right, hole.right);
+    if (top >= bottom || left >= right)
+    {
+      pieces[0] = tile;
+      return 1;
+    }
+
+    auto count = size_t{0};
+    if (tile.top < top)
+    {
+      pieces[count++] = Fractal_view::Pixel_view{tile.left, tile.top, tile.right, top};
+    }
+    if (bottom < tile.bottom)
+    {
+      pieces[count++] = Fractal_view::Pixel_view{tile.left, bottom, tile.right, tile.bottom};
+    }
+    if (tile.left < left)
+    {
+      pieces[count++] = Fractal_view::Pixel_view{tile.left, top, left, bottom};
+    }
+    if (right < tile.right)
+    {
+      pieces[count++] = Fractal_view::Pixel_view{right, top, tile.right, bottom};
+    }
+    return count;
+  }
+
+  static Fractal_view::Complex_view complex_view_(const Fractal_view& view, const Fractal_view::Pixel_view& tile)
+  {
+    const auto& pixels = view.pixel_view();
+    const auto& complex = view.complex_view();
+    auto real_factor = complex.width() / static_cast<double>(pixels.width());
+    auto imaginary_factor = complex.height() / static_cast<double>(pixels.height());
+    return Fractal_view::Complex_view{complex.left + (tile.left - pixels.left) * real_factor,
+                                      complex.top + (tile.top - pixels.top) * imaginary_factor,
+                                      complex.left + (tile.right - pixels.left) * real_factor,
+                                      complex.top + (tile.bottom - pixels.top) * imaginary_factor};
+  }
+
+  static double resolution_bits_(const Fractal_view& view, const Fractal_view::Complex_view& tile)
+  {
+    auto magnitude = std::max(std::max(std::fabs(tile.left), std::fabs(tile.right)), std::max(std::fabs(tile.top), std::fabs(tile.bottom)));
+    return Fractal::resolution_bits(view.pixel_spacing(), magnitude);
+  }
 };
 
 }
@@ -0,0 +1,249 @@
+//
+//  tile_range.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef tile_range_h
+#define tile_range_h
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fractal_view.h"
+#include "symmetry.h"
+#include "task_parameters.h"
+
+namespace Fractal
+{
+
+// One tile of a Tile_range: the cell of the grid, in the order of the range, and which of the pieces of the cell left
+// once the mirrored part of the view is taken out.  The rest is made from the range when the tile is rendered.
+struct Tile_descriptor
+{
+  uint32_t index;
+  uint32_t piece;
+};
+
+static_assert(std::is_trivially_copyable<Tile_descriptor>::value, "Tile descriptors are copied around as plain data");
+
+// The tiles Generator_task_parameters::distribute would cut a view into, made one at a time rather than all up
+// front.  What every tile shares, the identifier, cancel token, callbacks and view, is kept once in prototype(), a
+// tile only fills in its own rectangle, precision and mirror (see describe).  Distributed_generator::submit renders a
+// range without a heap allocation per tile, which tells once the tiles of a large view number in the thousands.
+class Tile_range final
+{
+public:
+  Tile_range() = default;
+  template <typename Completed_callback, typename Canceled_callback>
+  Tile_range(std::string task_identifier,
+             std::shared_ptr<std::atomic<bool>> cancel_token,
+             Completed_callback on_task_completed,
+             Canceled_callback on_task_canceled,
+             Fractal_view view,
+             size_t tile_width,
+             size_t tile_height,
+             Symmetry symmetry = Symmetry::none)
+  {
+    m_prototype.identifier = std::move(task_identifier);
+    m_prototype.cancel_token = std::move(cancel_token);
+    m_prototype.on_task_completed = on_task_completed;
+    m_prototype.on_task_canceled = on_task_canceled;
+    m_prototype.fractal_view = std::move(view);
+
+    const auto& pixels = m_prototype.fractal_view.pixel_view();
+    if (tile_width == 0 || tile_height == 0 || tile_width >= pixels.width() || tile_height >= pixels.height())
+    {
+      m_tile_width = pixels.width();
+      m_tile_height = pixels.height();
+    }
+    else
+    {
+      m_tile_width = tile_width;
+      m_tile_height = tile_height;
+      m_columns = (pixels.width() + tile_width - 1) / tile_width;
+      m_rows = (pixels.height() + tile_height - 1) / tile_height;
+    }
+
+    m_symmetric = Generator_task_parameters::mirrored_view_(m_prototype.fractal_view, symmetry, m_mirrored, m_row_sum, m_column_sum);
+    if (m_symmetric)
+    {
+      m_symmetry = symmetry;
+      m_source = Generator_task_parameters::mirror_(m_mirrored, symmetry, m_row_sum, m_column_sum);
+    }
+
+    Fractal_view::Pixel_view pieces[4];
+    for (size_t index = 0; index < size(); ++index)
+    {
+      m_tile_count += pieces_(cell_(index), pieces);
+    }
+  }
+  Tile_range(const Tile_range&) = default;
+  Tile_range(Tile_range&&) = default;
+  ~Tile_range() = default;
+
+  Tile_range& operator=(const Tile_range&) = default;
+  Tile_range& operator=(Tile_range&&) = default;
+
+  // Cells of the grid.
+  size_t size() const
+  {
+    return m_columns * m_rows;
+  }
+
+  // Tiles over all the cells, a cell straddling the mirrored part of the view makes several.
+  size_t tile_count() const
+  {
+    return m_tile_count;
+  }
+
+  Generator_task_parameters& prototype()
+  {
+    return m_prototype;
+  }
+
+  const Generator_task_parameters& prototype() const
+  {
+    return m_prototype;
+  }
+
+  // Priority of the range in the pool, its cells are started in the order of the range.
+  int priority() const
+  {
+    return m_priority;
+  }
+
+  void set_priority(int priority)
+  {
+    m_priority = priority;
+  }
+
+  // Orders the cells like Generator_task_parameters::order orders tiles.
+  void order(Tile_order tile_order, size_t focus_x = 0, size_t focus_y = 0)
+  {
+    m_order.clear();
+    if (tile_order == Tile_order::distributed)
+    {
+      return;
+    }
+
+    using Ranked = std::pair<double, uint32_t>;
+    auto ranks = std::vector<Ranked>{};
+    ranks.reserve(size());
+    for (size_t index = 0; index < size(); ++index)
+    {
+      auto rank = Generator_task_parameters::rank_(tile_order, m_prototype.fractal_view.pixel_view(), cell_(index), focus_x, focus_y);
+      ranks.emplace_back(rank, static_cast<uint32_t>(index));
+    }
+    std::sort(ranks.begin(), ranks.end());
+
+    m_order.reserve(ranks.size());
+    for (const auto& ranked : ranks)
+    {
+      m_order.push_back(ranked.second);
+    }
+  }
+
+  // Calls visit with each tile of the cell at index.
+  template <typename Visit>
+  void for_each_tile(size_t index, Visit visit) const
+  {
+    Fractal_view::Pixel_view pieces[4];
+    auto count = pieces_(cell_(index), pieces);
+    for (size_t piece = 0; piece < count; ++piece)
+    {
+      visit(Tile_descriptor{static_cast<uint32_t>(index), static_cast<uint32_t>(piece)});
+    }
+  }
+
+  // Fills in the fields of tp that are particular to the tile, tp otherwise being a copy of prototype().
+  void describe(const Tile_descriptor& tile, Generator_task_parameters& tp) const
+  {
+    const auto& view = m_prototype.fractal_view;
+    Fractal_view::Pixel_view pieces[4];
+    pieces_(cell_(tile.index), pieces);
+    const auto& piece = pieces[tile.piece];
+
+    tp.pixel_tile_view = piece;
+    tp.complex_tile_view = Generator_task_parameters::complex_view_(view, piece);
+    tp.resolution_bits = Generator_task_parameters::resolution_bits_(view, tp.complex_tile_view);
+    tp.priority = m_priority;
+    tp.symmetry = Symmetry::none;
+    tp.mirror_source_view = Fractal_view::Pixel_view{};
+    tp.mirror_target_view = Fractal_view::Pixel_view{};
+    if (!m_symmetric)
+    {
+      return;
+    }
+
+    auto overlap = Fractal_view::Pixel_view{std::max(piece.left, m_source.left),
+                                            std::max(piece.top, m_source.top),
+                                            std::min(piece.right, m_source.right),
+                                            std::min(piece.bottom, m_source.bottom)};
+    if (overlap.left < overlap.right && overlap.top < overlap.bottom)
+    {
+      tp.symmetry = m_symmetry;
+      tp.mirror_source_view = overlap;
+      tp.mirror_target_view = Generator_task_parameters::mirror_(overlap, m_symmetry, m_row_sum, m_column_sum);
+    }
+  }
+
+private:
+  // Cells go down the columns one after the other, like distribute makes them, the last row and column take what is
+  // left of the view.
+  Fractal_view::Pixel_view cell_(size_t index) const
+  {
+    auto cell = m_order.empty() ? index : m_order[index];
+    auto column = cell / m_rows;
+    auto row = cell % m_rows;
+    const auto& pixels = m_prototype.fractal_view.pixel_view();
+    auto left = pixels.left + column * m_tile_width;
+    auto top = pixels.top + row * m_tile_height;
+    return Fractal_view::Pixel_view{left,
+                                    top,
+                                    column == m_columns - 1 ? pixels.right : left + m_tile_width,
+                                    row == m_rows - 1 ? pixels.bottom : top + m_tile_height};
+  }
+
+  size_t pieces_(const Fractal_view::Pixel_view& cell, Fractal_view::Pixel_view (&pieces)[4]) const
+  {
+    if (!m_symmetric)
+    {
+      pieces[0] = cell;
+      return 1;
+    }
+    return Generator_task_parameters::subtract_(cell, m_mirrored, pieces);
+  }
+
+private:
+  Generator_task_parameters m_prototype;
+  size_t m_tile_width{0};
+  size_t m_tile_height{0};
+  size_t m_columns{1};
+  size_t m_rows{1};
+  size_t m_tile_count{0};
+  int m_priority{0};
+  // Cells in the order they are rendered, empty for the order of the grid.
+  std::vector<uint32_t> m_order;
+  // Set when the view straddles the symmetry of the function, see Generator_task_parameters::distribute.
+  bool m_symmetric{false};
+  Symmetry m_symmetry{Symmetry::none};
+  Fractal_view::Pixel_view m_mirrored{};
+  Fractal_view::Pixel_view m_source{};
+  size_t m_row_sum{0};
+  size_t m_column_sum{0};
+};
+
+}
+
+#endif /* tile_range_h */
@@ -0,0 +1,604 @@
+//
+//  work_stealing_pool.h
+//  fractal
+//
+//  Created by Banks, Timothy on 10/17/26.
+//  Copyright © 2026 Banks, Timothy. All rights reserved.
+//
+
+#ifndef work_stealing_pool_h
+#define work_stealing_pool_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Fractal
+{
+
+// Chase-Lev deque (Le, Pop, Cohen and Zappa Nardelli's C11 formulation).  The owner pushes and pops at the bottom
+// without taking a lock, any other thread steals from the top.  T has to be trivially copyable, the pool stores
+// pointers.  Arrays outgrown are kept until the deque goes, a thief may still be reading one.
+template <typename T>
+class Work_stealing_deque final
+{
+public:
+  Work_stealing_deque()
+  : m_array{new Array_{s_initial_capacity}}
+  {
+    m_arrays.emplace_back(m_array.load(std::memory_order_relaxed));
+  }
+  Work_stealing_deque(const Work_stealing_deque&) = delete;
+  Work_stealing_deque(Work_stealing_deque&&) = delete;
+  ~Work_stealing_deque() = default;
+
+  Work_stealing_deque& operator=(const Work_stealing_deque&) = delete;
+  Work_stealing_deque& operator=(Work_stealing_deque&&) = delete;
+
+  // Owner only.
+  void push(T item)
+  {
+    auto bottom = m_bottom.load(std::memory_order_relaxed);
+    auto top = m_top.load(std::memory_order_acquire);
+    auto array = m_array.load(std::memory_order_relaxed);
+    if (bottom - top > static_cast<int64_t>(array->capacity) - 1)
+    {
+      array = grow_(array, top, bottom);
+    }
+    array->put(bottom, item);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Owner only, last in first out.  Returns false when the deque is empty.
+  bool pop(T& item)
+  {
+    auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    auto array = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto top = m_top.load(std::memory_order_relaxed);
+    if (top > bottom)
+    {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    item = array->get(bottom);
+    if (top == bottom)
+    {
+      // Last item, racing the thieves for it.
+      auto won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread, first in first out.  Returns false when the deque is empty or another thread got the item first.
+  bool steal(T& item)
+  {
+    auto top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+    {
+      return false;
+    }
+
+    auto array = m_array.load(std::memory_order_acquire);
+    item = array->get(top);
+    return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+  // A snapshot, only exact when no other thread is using the deque.
+  bool empty() const
+  {
+    return m_top.load(std::memory_order_acquire) >= m_bottom.load(std::memory_order_acquire);
+  }
+
+private:
+  static constexpr size_t s_initial_capacity = 64;
+
+  struct Array_
+  {
+    explicit Array_(size_t capacity_)
+    : capacity{capacity_},
+      items{new std::atomic<T>[capacity_]}
+    {
+    }
+
+    T get(int64_t index) const
+    {
+      return items[static_cast<size_t>(index) & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t index, T item)
+    {
+      items[static_cast<size_t>(index) & (capacity - 1)].store(item, std::memory_order_relaxed);
+    }
+
+    size_t capacity;
+    std::unique_ptr<std::atomic<T>[]> items;
+  };
+
+  Array_* grow_(Array_* array, int64_t top, int64_t bottom)
+  {
+    auto grown = new Array_{array->capacity * 2};
+    m_arrays.emplace_back(grown);
+    for (auto i = top; i < bottom; ++i)
+    {
+      grown->put(i, array->get(i));
+    }
+    m_array.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+private:
+  // Thieves write the top, the owner the bottom, padded apart so they don't share a cache line.  Padding rather
+  // than alignas, new only honours extended alignment from C++17 on.
+  std::atomic<int64_t> m_top{0};
+  char m_top_padding[64 - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> m_bottom{0};
+  char m_bottom_padding[64 - sizeof(std::atomic<int64_t>)];
+  std::atomic<Array_*> m_array;
+  std::vector<std::unique_ptr<Array_>> m_arrays;
+};
+
+// Counts the tasks of one job still to run, so whoever started the job can wait for its tasks alone rather than for
+// the whole pool.  A task adds the tasks it spawns before it is done itself, the count only reaches zero once the
+// job is over.
+class Task_group final
+{
+public:
+  Task_group() = default;
+  Task_group(const Task_group&) = delete;
+  Task_group(Task_group&&) = delete;
+  ~Task_group() = default;
+
+  Task_group& operator=(const Task_group&) = delete;
+  Task_group& operator=(Task_group&&) = delete;
+
+  void add(size_t count = 1)
+  {
+    m_pending_task_count.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  // Returns true for the task that brought the count to zero.  The count drops under the lock, a waiter can't see
+  // zero, return and destroy the group while the last task is still about to notify it.
+  bool done()
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_pending_task_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+      return false;
+    }
+
+    m_done_condition.notify_all();
+    return true;
+  }
+
+  bool finished() const
+  {
+    return m_pending_task_count.load(std::memory_order_acquire) == 0;
+  }
+
+  void wait()
+  {
+    auto lock = std::unique_lock<std::mutex>{m_mutex};
+    m_done_condition.wait(lock, [&]()
+    {
+      return finished();
+    });
+  }
+
+  template <typename Rep, typename Period>
+  bool wait_for(const std::chrono::duration<Rep, Period>& timeout)
+  {
+    auto lock = std::unique_lock<std::mutex>{m_mutex};
+    return m_done_condition.wait_for(lock, timeout, [&]()
+    {
+      return finished();
+    });
+  }
+
+private:
+  std::atomic<size_t> m_pending_task_count{0};
+  std::mutex m_mutex;
+  std::condition_variable m_done_condition;
+};
+
+// Thread pool where every worker owns a Work_stealing_deque.  Tasks pushed from a worker, such as the rectangles
+// subdivision splits a tile into, go to the bottom of its own deque and cost no lock.  Tasks pushed from other
+// threads land in a shared queue that workers take from a share at a time, so the lock is taken once per share
+// rather than once per task.  The shared queue hands out tasks of higher priority first, and tasks of the same
+// priority in the order they were pushed.  A worker that runs out of tasks steals from the top of the deque of a
+// random victim, spins for a little while and then parks until a task is pushed.
+class Work_stealing_pool final
+{
+public:
+  using Task = std::function<void()>;
+
+  Work_stealing_pool() = delete;
+  Work_stealing_pool(size_t thread_count)
+  {
+    thread_count = std::max(thread_count, size_t{1});
+    m_workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+      m_workers.emplace_back(new Worker_{i});
+    }
+
+    for (auto& worker : m_workers)
+    {
+      auto raw = worker.get();
+      worker->thread = std::thread{[this, raw]()
+      {
+        run_(*raw);
+      }};
+    }
+  }
+  Work_stealing_pool(const Work_stealing_pool&) = delete;
+  Work_stealing_pool(Work_stealing_pool&&) = delete;
+  ~Work_stealing_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock{m_park_mutex};
+      m_destructing = true;
+    }
+    m_park_condition.notify_all();
+    m_idle_condition.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+      worker->thread.join();
+    }
+
+    // Tasks nobody got to.
+    for (auto& worker : m_workers)
+    {
+      auto task = static_cast<Task*>(nullptr);
+      while (worker->deque.pop(task))
+      {
+        delete task;
+      }
+    }
+    for (auto& shared_task : m_shared_tasks)
+    {
+      delete shared_task.task;
+    }
+  }
+
+  Work_stealing_pool& operator=(const Work_stealing_pool&) = delete;
+  Work_stealing_pool& operator=(Work_stealing_pool&&) = delete;
+
+  size_t thread_count() const
+  {
+    return m_workers.size();
+  }
+
+  // Pool shared by the whole process, created on first use with set_shared_thread_count threads, one per hardware
+  // thread by default.
+  static std::shared_ptr<Work_stealing_pool> shared()
+  {
+    auto& instance = shared_instance_();
+    std::lock_guard<std::mutex> lock{instance.mutex};
+    if (!instance.pool)
+    {
+      auto thread_count = instance.thread_count;
+      if (thread_count == 0)
+      {
+        thread_count = std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t{1});
+      }
+      instance.pool = std::make_shared<Work_stealing_pool>(thread_count);
+    }
+    return instance.pool;
+  }
+
+  // Zero sizes the shared pool to the hardware.  A pool of another size already created is replaced for the callers
+  // of shared() from then on, those holding it keep it until they let it go.
+  static void set_shared_thread_count(size_t thread_count)
+  {
+    auto& instance = shared_instance_();
+    std::lock_guard<std::mutex> lock{instance.mutex};
+    instance.thread_count = thread_count;
+    if (instance.pool && thread_count != 0 && instance.pool->thread_count() != thread_count)
+    {
+      instance.pool.reset();
+    }
+  }
+
+  // The priority only orders the tasks pushed from outside the pool, a worker runs the tasks it pushes itself as
+  // soon as it can.
+  void push(Task task, int priority = 0)
+  {
+    auto pointer = new Task{std::move(task)};
+    m_pending_task_count.fetch_add(1, std::memory_order_relaxed);
+
+    auto worker = current_worker_();
+    if (worker && worker->pool == this)
+    {
+      worker->deque.push(pointer);
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock{m_shared_tasks_mutex};
+      m_shared_tasks.push_back(Shared_task_{priority, m_shared_task_sequence++, pointer});
+      std::push_heap(m_shared_tasks.begin(), m_shared_tasks.end());
+      m_shared_task_count.store(m_shared_tasks.size(), std::memory_order_relaxed);
+    }
+
+    wake_();
+  }
+
+  // Whether the worker calling has nothing queued for others to steal.  A task working through a run of tiles hands
+  // the second half back to the pool then (lazy binary splitting), so runs are only split as far as workers go idle.
+  // True on threads outside the pool.
+  bool local_queue_empty() const
+  {
+    auto worker = current_worker_();
+    return !worker || worker->pool != this || worker->deque.empty();
+  }
+
+  // Blocks until every task pushed so far, and every task they pushed, has run.
+  void wait()
+  {
+    auto lock = std::unique_lock<std::mutex>{m_idle_mutex};
+    m_idle_condition.wait(lock, [&]()
+    {
+      return m_pending_task_count.load() == 0 || m_destructing;
+    });
+  }
+
+private:
+  // Rounds of looking for a task a worker goes through before parking.
+  static constexpr size_t s_spin_count = 64;
+
+  struct Worker_
+  {
+    explicit Worker_(size_t index_)
+    : index{index_},
+      random{0x9e3779b97f4a7c15ull * (index_ + 1)}
+    {
+    }
+
+    size_t index;
+    Work_stealing_pool* pool{nullptr};
+    Work_stealing_deque<Task*> deque;
+    // Scratch for take_shared_tasks_.
+    std::vector<Task*> taken;
+    uint64_t random;
+    std::thread thread;
+  };
+
+  struct Shared_instance_
+  {
+    std::mutex mutex;
+    size_t thread_count{0};
+    std::shared_ptr<Work_stealing_pool> pool;
+  };
+
+  static Shared_instance_& shared_instance_()
+  {
+    static Shared_instance_ instance;
+    return instance;
+  }
+
+  // The worker running on this thread, null on threads outside any pool.
+  static Worker_*& current_worker_()
+  {
+    thread_local Worker_* worker = nullptr;
+    return worker;
+  }
+
+  void run_(Worker_& worker)
+  {
+    worker.pool = this;
+    current_worker_() = &worker;
+
+    while (!m_destructing.load(std::memory_order_relaxed))
+    {
+      auto task = static_cast<Task*>(nullptr);
+      for (size_t spin = 0; spin < s_spin_count && !task; ++spin)
+      {
+        task = find_task_(worker);
+        if (!task)
+        {
+          std::this_thread::yield();
+        }
+      }
+
+      if (!task)
+      {
+        park_(worker);
+        continue;
+      }
+
+      try
+      {
+        (*task)();
+      }
+      catch (...)
+      {
+      }
+      delete task;
+
+      if (m_pending_task_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        std::lock_guard<std::mutex> lock{m_idle_mutex};
+        m_idle_condition.notify_all();
+      }
+    }
+  }
+
+  Task* find_task_(Worker_& worker)
+  {
+    auto task = static_cast<Task*>(nullptr);
+    if (worker.deque.pop(task))
+    {
+      return task;
+    }
+
+    if (take_shared_tasks_(worker, task))
+    {
+      return task;
+    }
+
+    // Random victims, then a sweep so a lone task can't be missed.
+    auto count = m_workers.size();
+    for (size_t attempt = 0; attempt < count; ++attempt)
+    {
+      auto& victim = *m_workers[next_random_(worker) % count];
+      if (&victim != &worker && victim.deque.steal(task))
+      {
+        return task;
+      }
+    }
+    for (auto& victim : m_workers)
+    {
+      if (victim.get() != &worker && victim->deque.steal(task))
+      {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  // Moves an even share of the shared queue to the worker's deque, the first task of it is run right away.
+  bool take_shared_tasks_(Worker_& worker, Task*& task)
+  {
+    if (m_shared_task_count.load(std::memory_order_relaxed) == 0)
+    {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock{m_shared_tasks_mutex};
+    if (m_shared_tasks.empty())
+    {
+      return false;
+    }
+
+    auto share = std::max(m_shared_tasks.size() / m_workers.size(), size_t{1});
+    auto& taken = worker.taken;
+    taken.clear();
+    for (size_t i = 0; i < share; ++i)
+    {
+      std::pop_heap(m_shared_tasks.begin(), m_shared_tasks.end());
+      taken.push_back(m_shared_tasks.back().task);
+      m_shared_tasks.pop_back();
+    }
+    m_shared_task_count.store(m_shared_tasks.size(), std::memory_order_relaxed);
+
+    // Pushed in reverse so the worker pops them in the order they were queued.
+    task = taken.front();
+    for (auto i = taken.size() - 1; i > 0; --i)
+    {
+      worker.deque.push(taken[i]);
+    }
+
+    // Others can steal from the share.
+    wake_();
+    return true;
+  }
+
+  static uint64_t next_random_(Worker_& worker)
+  {
+    // xorshift64
+    worker.random ^= worker.random << 13;
+    worker.random ^= worker.random >> 7;
+    worker.random ^= worker.random << 17;
+    return worker.random;
+  }
+
+  bool has_task_() const
+  {
+    if (m_shared_task_count.load(std::memory_order_relaxed) != 0)
+    {
+      return true;
+    }
+
+    for (const auto& worker : m_workers)
+    {
+      if (!worker->deque.empty())
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // A parking worker announces itself before looking for tasks one last time, a pusher publishes its task before
+  // looking for parked workers, the fences make sure at least one of them sees the other.
+  void park_(Worker_&)
+  {
+    auto lock = std::unique_lock<std::mutex>{m_park_mutex};
+    auto epoch = m_wake_epoch;
+    m_parked_count.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_task_())
+    {
+      m_park_condition.wait(lock, [&]()
+      {
+        return m_wake_epoch != epoch || m_destructing;
+      });
+    }
+    m_parked_count.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void wake_()
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_parked_count.load(std::memory_order_relaxed) == 0)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{m_park_mutex};
+      ++m_wake_epoch;
+    }
+    m_park_condition.notify_one();
+  }
+
+private:
+  std::vector<std::unique_ptr<Worker_>> m_workers;
+
+  // A heap, the task of highest priority pushed first on top.
+  struct Shared_task_
+  {
+    int priority;
+    uint64_t sequence;
+    Task* task;
+
+    bool operator<(const Shared_task_& other) const
+    {
+      return priority != other.priority ? priority < other.priority : sequence > other.sequence;
+    }
+  };
+
+  std::vector<Shared_task_> m_shared_tasks;
+  uint64_t m_shared_task_sequence{0};
+  std::mutex m_shared_tasks_mutex;
+  std::atomic<size_t> m_shared_task_count{0};
+
+  std::mutex m_park_mutex;
+  std::condition_variable m_park_condition;
+  std::atomic<size_t> m_parked_count{0};
+  uint64_t m_wake_epoch{0};
+
+  std::atomic<size_t> m_pending_task_count{0};
+  std::mutex m_idle_mutex;
+  std::condition_variable m_idle_condition;
+  std::atomic<bool> m_destructing{false};
+};
+
+}
+
+#endif /* work_stealing_pool_h */
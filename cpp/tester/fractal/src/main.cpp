@@ -83,16 +83,17 @@ int main(int argc, const char * argv[])
   auto on_task_completed = [](const Fractal::Task_parameters&){};
   auto on_task_canceled = [](const Fractal::Task_parameters&){};
   auto cancel_token = std::make_shared<std::atomic<bool>>(false);
-  auto tasks = Fractal::Generator_task_parameters::distribute("1",
-                                                              cancel_token,
-                                                              on_task_completed,
-                                                              on_task_canceled,
-                                                              fractal_view,
-                                                              512,
-                                                              512);
+  auto tiles = Fractal::Tile_range{"1",
+                                   cancel_token,
+                                   on_task_completed,
+                                   on_task_canceled,
+                                   fractal_view,
+                                   512,
+                                   512,
+                                   function.symmetry()};
   
-  auto generator = Fractal::Distributed_generator{3};
-  generator(std::move(function), tasks);
+  auto generator = Fractal::Distributed_generator{};
+  generator(std::move(function), std::move(tiles));
 
   auto stream = std::ofstream{"/Users/banksti/Documents/projects/fractal/fractal/mandelbrot.ppm"};
   auto width = fractal_view.pixel_view().width();
@@ -11,6 +11,7 @@ constexpr auto s_default_scale = double{0.00403897};
 constexpr auto s_zoom_in_factor = double{0.8};
 constexpr auto s_zoom_out_factor = double{1 / s_zoom_in_factor};
 constexpr auto s_scroll_step = int32_t{20};
+constexpr auto s_supersampling = int{4};
 
 MandelbrotWidget::MandelbrotWidget(QWidget *parent)
 : QWidget(parent),
@@ -61,7 +62,8 @@ void MandelbrotWidget::paintEvent(QPaintEvent * /* event */)
     }
 
     QString text = tr("Use mouse wheel or the '+' and '-' keys to zoom. "
-                      "Press and hold left mouse button to scroll.");
+                      "Press and hold left mouse button to scroll. "
+                      "Press 'A' to toggle antialiasing.");
     auto metrics = painter.fontMetrics();
     auto textWidth = metrics.horizontalAdvance(text);
 
@@ -74,7 +76,7 @@ void MandelbrotWidget::paintEvent(QPaintEvent * /* event */)
 
 void MandelbrotWidget::resizeEvent(QResizeEvent * /* event */)
 {
-    m_thread.render(m_center_x, m_center_y, m_current_scale, size());
+    m_thread.render(m_center_x, m_center_y, m_current_scale, size(), m_supersampling);
 }
 
 void MandelbrotWidget::keyPressEvent(QKeyEvent *event)
@@ -98,6 +100,9 @@ void MandelbrotWidget::keyPressEvent(QKeyEvent *event)
     case Qt::Key_Up:
         scroll(0, +s_scroll_step);
         break;
+    case Qt::Key_A:
+        toggleAntialiasing();
+        break;
     default:
         QWidget::keyPressEvent(event);
     }
@@ -161,7 +166,13 @@ void MandelbrotWidget::zoom(double zoomFactor)
 {
     m_current_scale *= zoomFactor;
     update();
-    m_thread.render(m_center_x, m_center_y, m_current_scale, size());
+    m_thread.render(m_center_x, m_center_y, m_current_scale, size(), m_supersampling);
+}
+
+void MandelbrotWidget::toggleAntialiasing()
+{
+    m_supersampling = m_supersampling > 1 ? 0 : s_supersampling;
+    m_thread.render(m_center_x, m_center_y, m_current_scale, size(), m_supersampling);
 }
 
 void MandelbrotWidget::scroll(int deltaX, int deltaY)
@@ -169,5 +180,5 @@ void MandelbrotWidget::scroll(int deltaX, int deltaY)
     m_center_x += deltaX * m_current_scale;
     m_center_y += deltaY * m_current_scale;
     update();
-    m_thread.render(m_center_x, m_center_y, m_current_scale, size());
+    m_thread.render(m_center_x, m_center_y, m_current_scale, size(), m_supersampling);
 }
@@ -29,6 +29,7 @@ private slots:
 
 private:
     void scroll(int deltaX, int deltaY);
+    void toggleAntialiasing();
 
     RenderThread m_thread;
     QPixmap m_pixmap;
@@ -38,6 +39,7 @@ private:
     double m_center_y{0.0};
     double m_pixmap_scale{0.0};
     double m_current_scale{0.};
+    int m_supersampling{0};
 };
 
 #endif // MANDELBROTWIDGET_H
@@ -3,6 +3,8 @@
 #include <QtWidgets>
 #include <cmath>
 
+#include <fractal/colormap.h>
+#include <fractal/distance_estimation_function.h>
 #include <fractal/distributed_generator.h>
 #include <fractal/fractal_view.h>
 #include <fractal/julia_function.h>
@@ -28,7 +30,7 @@ RenderThread::~RenderThread()
     wait();
 }
 
-void RenderThread::render(double center_x, double center_y, double scale_factor, QSize result_size)
+void RenderThread::render(double center_x, double center_y, double scale_factor, QSize result_size, int supersampling)
 {
     QMutexLocker locker(&m_mutex);
 
@@ -36,6 +38,7 @@ void RenderThread::render(double center_x, double center_y, double scale_factor,
     m_center_y = center_y;
     m_scale_factor = scale_factor;
     m_result_size = result_size;
+    m_supersampling = supersampling;
 
     if (!isRunning())
     {
@@ -56,12 +59,14 @@ void RenderThread::run()
         auto scale_factor = double{0.0};
         auto center_x = double{0.0};
         auto center_y = double{0.0};
+        auto supersampling = int{0};
         {
             QMutexLocker lock{&m_mutex};
             result_size = m_result_size;
             scale_factor = m_scale_factor;
             center_x = m_center_x;
             center_y = m_center_y;
+            supersampling = m_supersampling;
         }
 
         auto half_width = result_size.width() / 2;
@@ -74,29 +79,65 @@ void RenderThread::run()
                                                   center_y + (half_height * scale_factor)};
         auto fractal_view = Fractal::Fractal_view{std::move(pixel_view), std::move(complex_view)};
 
-        auto function = Fractal::Mandlebrot_function{1024};
+        auto colormap = Fractal::Colormap{std::vector<uint32_t>(std::begin(m_colormap), std::end(m_colormap))};
         //auto function = Fractal::Julia_function{{-0.8, 0.156}, 50};
 
         auto on_task_completed = [](const Fractal::Task_parameters&){};
         auto on_task_canceled = [](const Fractal::Task_parameters&){};
         //auto cancel_token = std::make_shared<std::atomic<bool>>(false);
-        auto tasks = Fractal::Generator_task_parameters::distribute("1",
-                                                                     m_cancel_token,
-                                                                     on_task_completed,
-                                                                     on_task_canceled,
-                                                                     fractal_view,
-                                                                     0,
-                                                                     0);
+        auto generate = [&](auto function)
+        {
+            // Tiles of about the same cost, so no single tile holds up the frame.  The first frame is probed, the
+            // others go by how long the last one took where they overlap it.
+            auto costs = m_cost_map ? m_cost_map : std::make_shared<Fractal::Cost_map>(Fractal::Cost_map::probe(fractal_view, 1024));
+            auto tasks = Fractal::Generator_task_parameters::distribute("1",
+                                                                         m_cancel_token,
+                                                                         on_task_completed,
+                                                                         on_task_canceled,
+                                                                         fractal_view,
+                                                                         *costs,
+                                                                         4 * Fractal::Work_stealing_pool::shared()->thread_count(),
+                                                                         function.symmetry());
+
+            auto frame_costs = std::make_shared<Fractal::Cost_map>(fractal_view);
+            auto generator = Fractal::Distributed_generator{};
+            generator.set_cost_map(frame_costs);
+            generator(function, tasks);
+
+            // A canceled frame only timed some of its tiles.
+            if (!m_cancel_token->load())
+            {
+                m_cost_map = frame_costs;
+            }
+        };
 
-        auto generator = Fractal::Distributed_generator{3};
-        generator(function, tasks);
+        if (supersampling > 1)
+        {
+            // Antialiased, only the pixels close to the boundary of the set are supersampled.
+            auto function = Fractal::Distance_estimation_function{1024};
+            function.set_colormap(std::move(colormap));
+            function.set_samples(static_cast<size_t>(supersampling));
+            function.set_pixel_spacing(fractal_view);
+            generate(std::move(function));
+        }
+        else
+        {
+            auto function = Fractal::Mandlebrot_function{1024};
+            function.set_colormap(std::move(colormap));
+            generate(std::move(function));
+        }
 
         if (!m_restart)
         {
-            auto image = QImage{reinterpret_cast<uchar*>(fractal_view.buffer().get()),
+            // The image keeps the buffer until its last copy is gone, the buffer then goes back to the framebuffer
+            // pool for a later frame.
+            auto buffer = new std::shared_ptr<uint32_t>{fractal_view.buffer()};
+            auto image = QImage{reinterpret_cast<uchar*>(buffer->get()),
                                 static_cast<int>(fractal_view.pixel_view().width()),
                                 static_cast<int>(fractal_view.pixel_view().height()),
-                                QImage::Format_ARGB32};
+                                QImage::Format_ARGB32,
+                                [](void* info) { delete static_cast<std::shared_ptr<uint32_t>*>(info); },
+                                buffer};
             emit renderedImage(image, scale_factor);
         }
 
@@ -6,6 +6,10 @@
 #include <QThread>
 #include <QWaitCondition>
 
+#include <memory>
+
+#include <fractal/cost_map.h>
+
 QT_BEGIN_NAMESPACE
 class QImage;
 QT_END_NAMESPACE
@@ -18,7 +22,7 @@ public:
     RenderThread(QObject *parent = 0);
     ~RenderThread();
 
-    void render(double center_x, double center_y, double scale_factor, QSize result_size);
+    void render(double center_x, double center_y, double scale_factor, QSize result_size, int supersampling);
 
 signals:
     void renderedImage(const QImage &image, double scale_factor);
@@ -35,9 +39,12 @@ private:
     double m_center_y{0};
     double m_scale_factor{0};
     QSize m_result_size;
+    int m_supersampling{0};
     bool m_restart{false};
     std::shared_ptr<std::atomic<bool>> m_cancel_token{std::make_shared<std::atomic<bool>>(false)};
     bool m_abort{false};
+    // How long the parts of the last frame took, the next one is cut into tiles of about the same cost with it.
+    std::shared_ptr<Fractal::Cost_map> m_cost_map;
 
     enum { ColormapSize = 512 };
     uint m_colormap[ColormapSize];
@@ -1,6 +1,14 @@
 import io
 import StringIO
 
+# reads a field added to the end of a message after it was first released, a message in the older, shorter format
+# ends before it and the field keeps its default
+def read_trailing(stream, parse, default):
+    line = stream.readline().strip()
+    if not line:
+        return default
+    return parse(line)
+
 class Message_header:
     # def __init__(self, type: int, identifier: str):
     def __init__(self, type, identifier):
@@ -147,16 +155,32 @@ class Geo_message_header:
 class Request_message:
     ID = 0
 
-    # def __init__(self, header: Geo_message_header, max_interations: int):
-    def __init__(self, header, max_interations):
+    # def __init__(self, header: Geo_message_header, max_interations: int, deep_zoom: bool, reference_real: str,
+    #              reference_imaginary: str, supersampling: int):
+    def __init__(self, header, max_interations, deep_zoom=False, reference_real='0', reference_imaginary='0',
+                 supersampling=0):
         self.header = header
         self.max_iterations = max_interations
+        # deep zoom requests give the complex view as offsets from a reference point whose coordinates are decimal
+        # strings of any precision
+        self.deep_zoom = deep_zoom
+        self.reference_real = reference_real
+        self.reference_imaginary = reference_imaginary
+        # samples per side of the grid pixels close to the boundary of the set are antialiased with, zero or one
+        # renders a single sample per pixel
+        self.supersampling = supersampling
 
     @classmethod
     def from_stream(cls, stream):
         header = Geo_message_header.from_stream(stream)
         max_iterations = int(stream.readline())
-        return Request_message(header, max_iterations)
+        # requests from before deep zoom end here
+        deep_zoom = read_trailing(stream, lambda line: bool(int(line)), False)
+        reference_real = read_trailing(stream, str, '0')
+        reference_imaginary = read_trailing(stream, str, '0')
+        # and from before supersampling here
+        supersampling = read_trailing(stream, int, 0)
+        return Request_message(header, max_iterations, deep_zoom, reference_real, reference_imaginary, supersampling)
 
     def clone(self):
         buffer = repr(self)
@@ -170,6 +194,18 @@ class Request_message:
         if self.max_iterations != other.max_iterations:
             return False
 
+        if self.deep_zoom != other.deep_zoom:
+            return False
+
+        if self.reference_real != other.reference_real:
+            return False
+
+        if self.reference_imaginary != other.reference_imaginary:
+            return False
+
+        if self.supersampling != other.supersampling:
+            return False
+
         return True
 
     def __ne__(self, other):
@@ -178,11 +214,20 @@ class Request_message:
     def __str__(self):
         result = str(self.header)
         result += 'Max Iterations: ' + str(self.max_iterations) + '\n'
+        if self.deep_zoom:
+            result += 'Reference Real: ' + self.reference_real + '\n'
+            result += 'Reference Imaginary: ' + self.reference_imaginary + '\n'
+        if self.supersampling > 1:
+            result += 'Supersampling: ' + str(self.supersampling) + '\n'
         return result
 
     def __repr__(self):
         result = repr(self.header)
         result += repr(self.max_iterations) + '\n'
+        result += str(int(self.deep_zoom)) + '\n'
+        result += self.reference_real + '\n'
+        result += self.reference_imaginary + '\n'
+        result += repr(self.supersampling) + '\n'
         return result
 
 class ARGB_buffer: